@@ -0,0 +1,243 @@
+// Accuracy of the float and 16.16 fixed-point geometry against the double baseline.
+// Every kernel is run on the same random inputs in each scalar type, position errors are
+// reported in pixels and tile units, and collision and tile lookups count disagreements.
+// The vectorized double batch transform is also held to the scalar double transform.
+//
+// Usage: accuracy [--samples n] [--tolerance pixels]
+//   exits with an error if any position is off by more than the tolerance (default 0.5 px),
+//   or if the double batch differs from the scalar transform by more than BATCH_EPSILON
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "utils.h"
+#include "track.h"
+#include "trackGenerator.h"
+#include "random.h"
+
+using namespace std;
+
+#define ACCURACY_SAMPLES 200000     // Random inputs per scenario
+#define ACCURACY_TOLERANCE 0.5      // Largest position error in pixels that passes
+#define BATCH_EPSILON 1e-9          // Largest difference in pixels between the double batch and scalar transforms
+#define BATCH_MAX_RUN 7             // Batches are run in lengths 1 to this, covering the paired and remainder paths
+
+// Screen and scroll state the kernels are compared under, as in benchmark.cpp
+struct Scenario {
+    const char* name;
+    double width;
+    double height;
+    double xRange;      // Inputs use x offsets in [-xRange, xRange] times the line spacing
+    int yLoop;
+};
+
+static const Scenario SCENARIOS[] = {
+    { "3ds", 400, 240, 1, 12 },
+    { "desktop", 900, 400, 1, 250 },
+    { "stressed", 3840, 2160, NO_V_LINES / 2, 1000000 },
+};
+
+// Error of one kernel in one scalar type
+struct Error {
+    double max;
+    double sum;
+    long count;
+    long mismatches;    // Discrete results that differ from double
+
+    Error() : max(0), sum(0), count(0), mismatches(0) {}
+
+    void add(double error) {
+        error = fabs(error);
+        max = error > max ? error : max;
+        sum += error;
+        count++;
+    }
+};
+
+struct Sample {
+    PointT<double> p;
+    double xOffset;
+    double yOffset;
+    int lane;
+    int row;
+};
+
+template <typename T>
+static PointT<T> convert(PointT<double> p) {
+    return PointT<T>(p.x, p.y);
+}
+
+static double pointError(PointT<double> expected, double x, double y) {
+    return fmax(fabs(x - expected.x), fabs(y - expected.y));
+}
+
+// Compares the instantiation for T against double on every sample of a scenario
+template <typename T>
+static void compare(const Scenario& s, const vector<Sample>& samples, const Track& track, const char* typeName,
+    double tolerance, bool& passed) {
+    PointT<double> pp = { s.width * 0.5, s.height * 0.25 };
+    PointT<T> ppT = convert<T>(pp);
+    Error perspective, batch, lineX, lineY, tilePosition, tileIndex, collision;
+
+    vector<PointT<double> > in(samples.size()), out(samples.size());
+    vector<PointT<T> > inT(samples.size()), outT(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        in[i] = samples[i].p;
+        inT[i] = convert<T>(samples[i].p);
+    }
+    transformPerspectiveBatch(in.data(), out.data(), (int) in.size(), pp, s.height);
+    transformPerspectiveBatch(inT.data(), outT.data(), (int) inT.size(), ppT, s.height);
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        const Sample& sample = samples[i];
+        PointT<T> pT = inT[i];
+
+        PointT<double> expected = transformPerspective(sample.p, pp, s.height);
+        PointT<T> actual = transformPerspective(pT, ppT, s.height);
+        perspective.add(pointError(expected, (double) actual.x, (double) actual.y));
+        batch.add(pointError(out[i], (double) outT[i].x, (double) outT[i].y));
+
+        lineX.add(getLineXFromIndex(sample.lane, pp, s.width, sample.xOffset) -
+            (double) getLineXFromIndex(sample.lane, ppT, s.width, sample.xOffset));
+        lineY.add(getLineYFromIndex<double>(sample.row, s.height, sample.yOffset) -
+            (double) getLineYFromIndex<T>(sample.row, s.height, sample.yOffset));
+
+        PointT<double> tile = getTilePosition(sample.p, pp, s.width, s.height, sample.xOffset, sample.yOffset);
+        PointT<T> tileT = getTilePosition(pT, ppT, s.width, s.height, sample.xOffset, sample.yOffset);
+        tilePosition.add(pointError(tile, (double) tileT.x, (double) tileT.y));
+
+        Index2 index = getTileIndex(sample.p, pp, s.width, s.height, sample.xOffset, sample.yOffset, s.yLoop);
+        Index2 indexT = getTileIndex(pT, ppT, s.width, s.height, sample.xOffset, sample.yOffset, s.yLoop);
+        tileIndex.count++;
+        if (index.x != indexT.x || index.y != indexT.y)
+            tileIndex.mismatches++;
+
+        bool hit = checkShipCollision(track, sample.p, pp, s.width, s.height, sample.xOffset, sample.yOffset,
+            s.yLoop);
+        bool hitT = checkShipCollision(track, pT, ppT, s.width, s.height, sample.xOffset, sample.yOffset,
+            s.yLoop);
+        collision.count++;
+        if (hit != hitT)
+            collision.mismatches++;
+    }
+
+    struct Row {
+        const char* kernel;
+        const Error& error;
+        const char* unit;
+        bool checked;   // Position in pixels, held to the tolerance
+    };
+    Row rows[] = {
+        { "transformPerspective", perspective, "px", true },
+        { "transformPerspectiveBatch", batch, "px", true },
+        { "getLineXFromIndex", lineX, "px", true },
+        { "getLineYFromIndex", lineY, "px", true },
+        { "getTilePosition", tilePosition, "tiles", false },
+        { "getTileIndex", tileIndex, "", false },
+        { "checkShipCollision", collision, "", false },
+    };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        const Row& row = rows[i];
+        bool ok = !row.checked || row.error.max <= tolerance;
+        passed = passed && ok;
+        if (row.unit[0])
+            printf("%-9s %-7s %-27s %12.3g %12.3g %-5s %10s %s\n", s.name, typeName, row.kernel, row.error.max,
+                row.error.sum / row.error.count, row.unit, "", ok ? "" : "FAIL");
+        else
+            printf("%-9s %-7s %-27s %12s %12s %-5s %9.4f%%\n", s.name, typeName, row.kernel, "", "", "",
+                100.0 * row.error.mismatches / row.error.count);
+    }
+}
+
+// Compares the vectorized double batch against the scalar double transform it replaces
+static void compareBatch(const Scenario& s, const vector<Sample>& samples, bool& passed) {
+    PointT<double> pp = { s.width * 0.5, s.height * 0.25 };
+    vector<PointT<double> > in(samples.size()), out(samples.size());
+    for (size_t i = 0; i < samples.size(); i++)
+        in[i] = samples[i].p;
+
+    // Runs of every length up to BATCH_MAX_RUN, so odd counts reach the scalar remainder
+    size_t begin = 0;
+    for (int run = 1; begin < in.size(); run = run % BATCH_MAX_RUN + 1) {
+        int count = (int) min((size_t) run, in.size() - begin);
+        transformPerspectiveBatch(in.data() + begin, out.data() + begin, count, pp, s.height);
+        begin += count;
+    }
+
+    Error error;
+    for (size_t i = 0; i < in.size(); i++) {
+        PointT<double> expected = transformPerspective(in[i], pp, s.height);
+        error.add(pointError(expected, out[i].x, out[i].y));
+    }
+
+    bool ok = error.max <= BATCH_EPSILON;
+    passed = passed && ok;
+    printf("%-9s %-7s %-27s %12.3g %12.3g %-5s %10s %s\n", s.name, "double", "batch vs scalar", error.max,
+        error.sum / error.count, "px", "", ok ? "" : "FAIL");
+}
+
+static void runScenario(const Scenario& s, int noSamples, double tolerance, bool& passed) {
+    double spacingX = V_LINE_SPACING * s.width;
+    double spacingY = H_LINE_SPACING * s.height;
+
+    // Points cover the screen and a margin around it, inputs are drawn from a fixed seed
+    Random random(12345);
+    vector<Sample> samples(noSamples);
+    for (int i = 0; i < noSamples; i++) {
+        Sample& sample = samples[i];
+        sample.p.x = (random.next() / 4294967296.0 * 1.5 - 0.25) * s.width;
+        sample.p.y = (random.next() / 4294967296.0 * 1.5 - 0.25) * s.height;
+        sample.xOffset = (random.next() / 4294967296.0 * 2 - 1) * s.xRange * spacingX;
+        sample.yOffset = random.next() / 4294967296.0 * spacingY;
+        sample.lane = random.nextInt(-(NO_V_LINES / 2) + 1, NO_V_LINES / 2);
+        sample.row = random.nextInt(-1, NO_H_LINES + 2);
+    }
+
+    // Track ahead of the loop, as the game would hold it
+    TrackGenerator generator(42);
+    Track track;
+    int nextRow = s.yLoop;
+    while (track.size() <= NO_TILES)
+        generator.addRow(track, nextRow++);
+
+    compareBatch(s, samples, passed);
+    compare<float>(s, samples, track, "float", tolerance, passed);
+    compare<Fixed16>(s, samples, track, "fixed", tolerance, passed);
+}
+
+int main(int argc, char** argv) {
+    int noSamples = ACCURACY_SAMPLES;
+    double tolerance = ACCURACY_TOLERANCE;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--samples") && hasValue)
+            noSamples = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tolerance") && hasValue)
+            tolerance = atof(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--samples n] [--tolerance pixels]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (noSamples <= 0) {
+        fprintf(stderr, "--samples must be positive\n");
+        return 1;
+    }
+
+    printf("%d samples per scenario, errors against double, build scalar %s\n\n", noSamples, SCALAR_NAME);
+    printf("%-9s %-7s %-27s %12s %12s %-5s %10s\n", "scenario", "type", "kernel", "max error", "mean error", "unit",
+        "mismatch");
+
+    bool passed = true;
+    for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++)
+        runScenario(SCENARIOS[i], noSamples, tolerance, passed);
+
+    if (!passed) {
+        printf("\nPosition error above %.3g px, or batch error above %.3g px\n", tolerance, BATCH_EPSILON);
+        return 1;
+    }
+    return 0;
+}
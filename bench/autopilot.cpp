@@ -0,0 +1,193 @@
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <algorithm>
+
+#include "autopilot.h"
+#include "keys.h"
+#include "random.h"
+
+using namespace std;
+
+#define HUMAN_MIN_DELAY 10      // Reaction delay range in frames
+#define HUMAN_MAX_DELAY 18
+#define HUMAN_POSITION_NOISE 0.08   // Standard deviation of the perceived ship lane
+#define HUMAN_TIMING_NOISE 0.15     // Standard deviation of the anticipated row
+#define HUMAN_LAPSE_CHANCE 0.01     // Chance per frame of letting go of the controls
+#define HUMAN_LAPSE_FRAMES 6
+#define RANDOM_MIN_HOLD 5       // Frames a random direction is held for
+#define RANDOM_MAX_HOLD 30
+
+const char* const AUTOPILOT_NAMES[] = { "greedy", "human", "random" };
+const int NO_AUTOPILOTS = sizeof(AUTOPILOT_NAMES) / sizeof(AUTOPILOT_NAMES[0]);
+
+// Returns the centre of the lane to steer for on the ship's row: the lane of the path
+// that carries on into the next row, so turns are taken as soon as they start
+static double getTargetLane(const GameWorld& world, int row) {
+    int target = TRACK_MIN_LANE - 1;
+    for (int lane = TRACK_MIN_LANE; lane <= TRACK_MAX_LANE; lane++) {
+        if (!world.tiles.isOccupied(lane, row))
+            continue;
+        if (target < TRACK_MIN_LANE || world.tiles.isOccupied(lane, row + 1))
+            target = lane;
+    }
+    return target + 0.5;
+}
+
+// Finds the lanes the path covers on a row, returns false if the row has no tiles
+static bool getPathSpan(const GameWorld& world, int row, int& low, int& high) {
+    low = TRACK_MAX_LANE + 1;
+    high = TRACK_MIN_LANE;
+    for (int lane = TRACK_MIN_LANE; lane <= TRACK_MAX_LANE; lane++) {
+        if (world.tiles.isOccupied(lane, row)) {
+            low = min(low, lane);
+            high = max(high, lane + 1);
+        }
+    }
+    return low < high;
+}
+
+// Picks the key that brings the ship closest to a lane after one frame, or none
+static uint32_t steerTowards(double shipLane, double targetLane, double deltaTime) {
+    // Left moves the track right, which moves the ship towards lower lanes
+    double step = SPEED_X * deltaTime / V_LINE_SPACING;
+    double error = targetLane - shipLane;
+    if (fabs(error) <= step / 2)
+        return 0;
+    return error < 0 ? KEY_BIT(LEFT_KEY) : KEY_BIT(RIGHT_KEY);
+}
+
+class GreedyAutopilot : public Autopilot {
+public:
+    const char* getName() const { return "greedy"; }
+    void reset(uint64_t seed) {}
+
+    void control(const GameWorld& world, InputFrame& frame) {
+        PointT<double> ship = getShipTilePosition(world.state, frame.width, frame.height);
+        double rowsPerFrame = world.state.speedY * NO_H_LINES * frame.deltaTime;
+        double step = SPEED_X * frame.deltaTime / V_LINE_SPACING;
+
+        // Once on the lane its row leads to, the ship lines up for the first turn it reaches in the
+        // frames it takes to cross a lane, so turns are started early enough at any speed
+        int row = (int) floor(ship.y);
+        int lastRow = (int) floor(ship.y + rowsPerFrame);
+        double target = getTargetLane(world, row);
+        if (floor(ship.x) == floor(target)) {
+            int horizon = (int) floor(ship.y + rowsPerFrame / step);
+            for (int ahead = row + 1; ahead <= horizon; ahead++) {
+                // Rows past the generated track have no lane
+                double next = getTargetLane(world, ahead);
+                if (next < TRACK_MIN_LANE)
+                    break;
+                if (next != target) {
+                    target = next;
+                    lastRow = max(lastRow, ahead - 1);
+                    break;
+                }
+            }
+        }
+
+        // The ship stays on every row it passes before it gets there
+        int low = TRACK_MIN_LANE;
+        int high = TRACK_MAX_LANE + 1;
+        for (int passed = row; passed <= lastRow; passed++) {
+            int rowLow, rowHigh;
+            if (getPathSpan(world, passed, rowLow, rowHigh)) {
+                low = max(low, rowLow);
+                high = min(high, rowHigh);
+            }
+        }
+        if (low < high)
+            target = min(max(target, low + step), high - step);
+        frame.heldKeys = steerTowards(ship.x, target, frame.deltaTime);
+    }
+};
+
+class HumanAutopilot : public Autopilot {
+public:
+    HumanAutopilot() : random(0), delay(HUMAN_MIN_DELAY), lapse(0) {}
+
+    const char* getName() const { return "human"; }
+
+    void reset(uint64_t seed) {
+        random = Random(hashSeed(seed, 1));
+        delay = random.nextInt(HUMAN_MIN_DELAY, HUMAN_MAX_DELAY);
+        targets.clear();
+        lapse = 0;
+    }
+
+    void control(const GameWorld& world, InputFrame& frame) {
+        PointT<double> ship = getShipTilePosition(world.state, frame.width, frame.height);
+
+        // Decisions act on what was on screen a reaction time ago, when the player judged
+        // which row the ship would be on by now, with some error
+        double rowsPerFrame = world.state.speedY * NO_H_LINES * frame.deltaTime;
+        double anticipatedRow = ship.y + rowsPerFrame * delay + HUMAN_TIMING_NOISE * nextGaussian();
+        targets.push_back(getTargetLane(world, (int) floor(anticipatedRow)));
+        if ((int) targets.size() > delay)
+            targets.pop_front();
+
+        if (lapse > 0 || nextUniform() < HUMAN_LAPSE_CHANCE) {
+            lapse = lapse > 0 ? lapse - 1 : HUMAN_LAPSE_FRAMES;
+            frame.heldKeys = 0;
+            return;
+        }
+
+        double perceivedLane = ship.x + HUMAN_POSITION_NOISE * nextGaussian();
+        frame.heldKeys = steerTowards(perceivedLane, targets.front(), frame.deltaTime);
+    }
+
+private:
+    Random random;
+    int delay;
+    deque<double> targets;
+    int lapse;
+
+    double nextUniform() {
+        return random.next() / 4294967296.0;
+    }
+
+    // Box-Muller transform
+    double nextGaussian() {
+        double u = 1.0 - nextUniform();
+        double v = nextUniform();
+        return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+    }
+};
+
+class RandomAutopilot : public Autopilot {
+public:
+    RandomAutopilot() : random(0), keys(0), hold(0) {}
+
+    const char* getName() const { return "random"; }
+
+    void reset(uint64_t seed) {
+        random = Random(hashSeed(seed, 2));
+        keys = 0;
+        hold = 0;
+    }
+
+    void control(const GameWorld& world, InputFrame& frame) {
+        if (hold-- <= 0) {
+            static const uint32_t CHOICES[] = { 0, KEY_BIT(LEFT_KEY), KEY_BIT(RIGHT_KEY) };
+            keys = CHOICES[random.nextInt(0, 2)];
+            hold = random.nextInt(RANDOM_MIN_HOLD, RANDOM_MAX_HOLD);
+        }
+        frame.heldKeys = keys;
+    }
+
+private:
+    Random random;
+    uint32_t keys;
+    int hold;
+};
+
+Autopilot* createAutopilot(const char* name) {
+    if (!strcmp(name, "greedy"))
+        return new GreedyAutopilot();
+    if (!strcmp(name, "human"))
+        return new HumanAutopilot();
+    if (!strcmp(name, "random"))
+        return new RandomAutopilot();
+    return nullptr;
+}
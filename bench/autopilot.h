@@ -0,0 +1,34 @@
+// Policies that play the game without a player, for the batch simulator.
+
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <cstdint>
+
+#include "simulation.h"
+#include "inputRecording.h"
+
+// Chooses the input of each frame from the state of a game
+class Autopilot {
+public:
+    virtual ~Autopilot() {}
+
+    virtual const char* getName() const = 0;
+    // Starts a new game, the policy's own randomness is seeded from it
+    virtual void reset(uint64_t seed) = 0;
+    // Sets the held keys of the next frame, whose time and screen size are already set
+    virtual void control(const GameWorld& world, InputFrame& frame) = 0;
+};
+
+// Names accepted by createAutopilot, in report order
+extern const char* const AUTOPILOT_NAMES[];
+extern const int NO_AUTOPILOTS;
+
+// Creates a policy by name, returns nullptr if there is none with that name
+//  - greedy: steers for the lane the path continues in and lines up for turns ahead, with
+//    perfect reactions
+//  - human: the greedy target seen with a reaction delay, noisy position and lapses
+//  - random: holds a random direction for a random time
+Autopilot* createAutopilot(const char* name);
+
+#endif // AUTOPILOT_H
@@ -0,0 +1,231 @@
+// Plays many headless games across all cores with autopilot policies and reports
+// score distributions, simulation throughput and how the games ended.
+// Builds on Linux against the portable sources only, see bench/Makefile.
+//
+// Usage: batch [--games n] [--threads n] [--policy name] [--seed n] [--fps n]
+//              [--max-seconds n] [--worst n] [--csv file]
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+#include "simulation.h"
+#include "random.h"
+#include "autopilot.h"
+
+using namespace std;
+
+#define BATCH_WIDTH 400         // Games are simulated at the 3DS top screen size
+#define BATCH_HEIGHT 240
+#define NO_CRASH_CAUSES (CRASH_TURN_RIGHT + 1)
+
+struct Options {
+    int games = 1000;
+    int threads = 0;            // 0 uses every core
+    string policy;              // Empty runs every policy
+    uint64_t seed = 1;
+    double fps = 60;
+    double maxSeconds = 600;    // Games still running after this long count as survived
+    int worst = 10;             // Earliest greedy deaths to list
+    const char* csv = nullptr;
+};
+
+struct GameResult {
+    int policy;
+    uint64_t seed;
+    int score;
+    int frames;
+    CrashCause crash;           // CRASH_NONE if the game survived
+    Index2 crashTile;
+    double seconds;             // Time spent simulating the game
+};
+
+// Plays one game to its end or to the time limit
+static GameResult playGame(Autopilot& autopilot, uint64_t seed, const Options& options) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    GameWorld world(seed);
+    autopilot.reset(seed);
+
+    InputFrame frame;
+    frame.touch = { -1, -1 };
+    frame.drag = { 0, 0 };
+    frame.deltaTime = 1.0 / options.fps;
+    frame.width = BATCH_WIDTH;
+    frame.height = BATCH_HEIGHT;
+
+    GameResult result = {};
+    int maxFrames = (int) (options.maxSeconds * options.fps);
+    while (result.frames < maxFrames) {
+        autopilot.control(world, frame);
+        result.frames++;
+        if (!simulateFrame(world, frame))
+            break;
+    }
+
+    result.seed = seed;
+    result.score = getScore(world);
+    result.crash = world.crash;
+    result.crashTile = world.crashTile;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Returns the value at the given percentile of a sorted list
+static int percentile(const vector<int>& sorted, double p) {
+    return sorted[(size_t) (p * (sorted.size() - 1) + 0.5)];
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--games") && hasValue)
+            options.games = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--policy") && hasValue)
+            options.policy = argv[++i];
+        else if (!strcmp(argv[i], "--seed") && hasValue)
+            options.seed = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--fps") && hasValue)
+            options.fps = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--max-seconds") && hasValue)
+            options.maxSeconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--worst") && hasValue)
+            options.worst = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--csv") && hasValue)
+            options.csv = argv[++i];
+        else
+            return false;
+    }
+    return options.games > 0 && options.fps > 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s [--games n] [--threads n] [--policy name] [--seed n] [--fps n]\n"
+            "       [--max-seconds n] [--worst n] [--csv file]\n", argv[0]);
+        return 2;
+    }
+
+    vector<int> policies;
+    for (int i = 0; i < NO_AUTOPILOTS; i++) {
+        if (options.policy.empty() || options.policy == AUTOPILOT_NAMES[i])
+            policies.push_back(i);
+    }
+    if (policies.empty()) {
+        fprintf(stderr, "Unknown policy %s\n", options.policy.c_str());
+        return 2;
+    }
+
+    int threads = options.threads > 0 ? options.threads : (int) thread::hardware_concurrency();
+    threads = max(threads, 1);
+
+    // Games are handed out one at a time, each writes only its own result
+    int total = options.games * (int) policies.size();
+    vector<GameResult> results(total);
+    atomic<int> nextGame(0);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&]() {
+            vector<Autopilot*> autopilots;
+            for (int policy : policies)
+                autopilots.push_back(createAutopilot(AUTOPILOT_NAMES[policy]));
+
+            int i;
+            while ((i = nextGame.fetch_add(1)) < total) {
+                int policy = i / options.games;
+                uint64_t seed = hashSeed(options.seed, i % options.games);
+                results[i] = playGame(*autopilots[policy], seed, options);
+                results[i].policy = policies[policy];
+            }
+
+            for (Autopilot* autopilot : autopilots)
+                delete autopilot;
+        }));
+    }
+    for (thread& worker : workers)
+        worker.join();
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%d games per policy, %d threads, %.0f fps, SPEED_Y_INC_PER_SND %g, NO_TILES %d\n\n",
+        options.games, threads, options.fps, (double) SPEED_Y_INC_PER_SND, NO_TILES);
+    printf("%-8s %10s %12s %8s %6s %6s %6s %6s %6s %9s", "policy", "frames", "frames/s/core", "mean",
+        "min", "p10", "p50", "p90", "max", "survived");
+    for (int cause = CRASH_OFF_LEFT; cause < NO_CRASH_CAUSES; cause++)
+        printf(" %10s", getCrashCauseName((CrashCause) cause));
+    printf("\n");
+
+    long long totalFrames = 0;
+    for (size_t p = 0; p < policies.size(); p++) {
+        vector<int> scores;
+        long long frames = 0;
+        double seconds = 0;
+        int causes[NO_CRASH_CAUSES] = {};
+        for (int i = 0; i < options.games; i++) {
+            const GameResult& result = results[p * options.games + i];
+            scores.push_back(result.score);
+            frames += result.frames;
+            seconds += result.seconds;
+            causes[result.crash]++;
+        }
+        totalFrames += frames;
+        sort(scores.begin(), scores.end());
+
+        double mean = 0;
+        for (int score : scores)
+            mean += score;
+        mean /= scores.size();
+
+        printf("%-8s %10lld %12.0f %8.1f %6d %6d %6d %6d %6d %9d", AUTOPILOT_NAMES[policies[p]], frames,
+            frames / seconds, mean, scores.front(), percentile(scores, 0.1), percentile(scores, 0.5),
+            percentile(scores, 0.9), scores.back(), causes[CRASH_NONE]);
+        for (int cause = CRASH_OFF_LEFT; cause < NO_CRASH_CAUSES; cause++)
+            printf(" %10d", causes[cause]);
+        printf("\n");
+    }
+    printf("\n%lld frames in %.3f s, %.0f simulated frames/s, %.0fx real time\n", totalFrames, wallSeconds,
+        totalFrames / wallSeconds, totalFrames / wallSeconds / options.fps);
+
+    // A greedy player has perfect reactions and starts each turn as early as the path allows,
+    // so its earliest deaths point at track segments that may be unfair
+    vector<const GameResult*> deaths;
+    for (const GameResult& result : results) {
+        if (!strcmp(AUTOPILOT_NAMES[result.policy], "greedy") && result.crash != CRASH_NONE)
+            deaths.push_back(&result);
+    }
+    sort(deaths.begin(), deaths.end(), [](const GameResult* a, const GameResult* b) {
+        return a->crashTile.y < b->crashTile.y;
+    });
+    if (!deaths.empty() && options.worst > 0) {
+        printf("\nEarliest greedy deaths:\n");
+        for (int i = 0; i < options.worst && i < (int) deaths.size(); i++) {
+            printf("  seed %llu: row %d, lane %d, %s\n", (unsigned long long) deaths[i]->seed,
+                deaths[i]->crashTile.y, deaths[i]->crashTile.x, getCrashCauseName(deaths[i]->crash));
+        }
+    }
+
+    if (options.csv) {
+        FILE* file = fopen(options.csv, "w");
+        if (!file) {
+            fprintf(stderr, "Could not write %s\n", options.csv);
+            return 1;
+        }
+        fprintf(file, "policy,seed,score,frames,crash,crash_lane,crash_row\n");
+        for (const GameResult& result : results) {
+            fprintf(file, "%s,%llu,%d,%d,%s,%d,%d\n", AUTOPILOT_NAMES[result.policy],
+                (unsigned long long) result.seed, result.score, result.frames, getCrashCauseName(result.crash),
+                result.crashTile.x, result.crashTile.y);
+        }
+        fclose(file);
+    }
+    return 0;
+}
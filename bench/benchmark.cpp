@@ -0,0 +1,290 @@
+// Microbenchmarks for the geometry, collision and track generation kernels.
+// Builds on Linux against the portable sources only, see bench/Makefile.
+//
+// Usage: benchmark [--filter text] [--save file] [--baseline file]
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "utils.h"
+#include "track.h"
+#include "trackGenerator.h"
+#include "random.h"
+#include "lattice.h"
+
+using namespace std;
+
+#define BENCH_SAMPLES 31        // Timed batches per benchmark, percentiles are taken over these
+#define BENCH_BATCH_NS 2000000  // Target duration of one batch
+#define BENCH_INPUTS 1024       // Precomputed inputs cycled through so calls cannot be folded away
+#define BENCH_THRESHOLD 0.05    // Relative change against the baseline reported as a regression
+
+// Screen and scroll state a kernel is measured under
+struct Scenario {
+    const char* name;
+    double width;
+    double height;
+    double xRange;      // Inputs use x offsets in [-xRange, xRange] times the line spacing
+    int yLoop;
+};
+
+static const Scenario SCENARIOS[] = {
+    { "3ds", 400, 240, 1, 12 },
+    { "desktop", 900, 400, 1, 250 },
+    // 4K screen far down the track, with the ship swept across the whole grid
+    { "stressed", 3840, 2160, NO_V_LINES / 2, 1000000 },
+};
+
+struct Result {
+    string name;
+    double p10;
+    double p50;
+    double p90;
+};
+
+static volatile double sink;
+
+static double nowNs() {
+    return (double) chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Times op(i) for increasing i and returns ns/op percentiles over BENCH_SAMPLES batches
+template <typename Op>
+static Result measure(const string& name, Op op) {
+    // Calibrate the batch size to roughly BENCH_BATCH_NS
+    long iterations = 1;
+    while (true) {
+        double start = nowNs();
+        double acc = 0;
+        for (long i = 0; i < iterations; i++)
+            acc += op(i);
+        sink = acc;
+        if (nowNs() - start >= BENCH_BATCH_NS / 4 || iterations >= (1L << 30))
+            break;
+        iterations *= 2;
+    }
+    iterations *= 4;
+
+    vector<double> samples;
+    long i = 0;
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        double start = nowNs();
+        double acc = 0;
+        for (long end = i + iterations; i < end; i++)
+            acc += op(i);
+        sink = acc;
+        samples.push_back((nowNs() - start) / iterations);
+    }
+    sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.p10 = samples[BENCH_SAMPLES / 10];
+    result.p50 = samples[BENCH_SAMPLES / 2];
+    result.p90 = samples[BENCH_SAMPLES * 9 / 10];
+    return result;
+}
+
+// Fills a track with the rows ahead of the given loop, as startGame does
+static void fillTrack(Track& track, TrackGenerator& generator, int& nextRow, int yLoop) {
+    track.removeBefore(yLoop);
+    while (track.size() <= NO_TILES)
+        generator.addRow(track, nextRow++);
+}
+
+// Measures op unless its name does not match the filter, so filtering shortens the run
+template <typename Op>
+static void add(vector<Result>& results, const char* filter, const string& name, Op op) {
+    if (filter && name.find(filter) == string::npos)
+        return;
+    results.push_back(measure(name, op));
+}
+
+static void runScenario(const Scenario& s, const char* filter, vector<Result>& results) {
+    Point pp = { s.width * 0.5, s.height * 0.25 };
+    double spacingX = V_LINE_SPACING * s.width;
+    double spacingY = H_LINE_SPACING * s.height;
+    Point shipCenter = { s.width / 2, s.height - SHIP_BASE_Y * s.height - SHIP_HEIGHT * s.height / 2 };
+
+    // Inputs are drawn from a fixed seed so runs are comparable
+    Random random(12345);
+    vector<Point> points(BENCH_INPUTS);
+    vector<double> xOffsets(BENCH_INPUTS);
+    vector<double> yOffsets(BENCH_INPUTS);
+    vector<int> lanes(BENCH_INPUTS);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        points[i] = { random.next() / 4294967296.0 * s.width, random.next() / 4294967296.0 * s.height };
+        xOffsets[i] = (random.next() / 4294967296.0 * 2 - 1) * s.xRange * spacingX;
+        yOffsets[i] = random.next() / 4294967296.0 * spacingY;
+        lanes[i] = random.nextInt(TRACK_MIN_LANE, TRACK_MAX_LANE);
+    }
+
+    // Track ahead of the ship, positioned with the path from the track generator
+    TrackGenerator generator(42);
+    Track track;
+    int nextRow = s.yLoop;
+    fillTrack(track, generator, nextRow, s.yLoop);
+
+    string suffix = string("/") + s.name;
+    const int mask = BENCH_INPUTS - 1;
+
+    add(results, filter, "transformPerspective" + suffix, [&](long i) {
+        Point p = transformPerspective(points[i & mask], pp, s.height);
+        return (double) (p.x + p.y);
+    });
+
+    Point batch[BENCH_INPUTS];
+    add(results, filter, "transformPerspectiveBatch" + suffix, [&](long i) {
+        // Reported per point
+        if ((i & mask) == 0)
+            transformPerspectiveBatch(points.data(), batch, BENCH_INPUTS, pp, s.height);
+        return (double) batch[i & mask].x;
+    });
+
+    add(results, filter, "getLineXFromIndex" + suffix, [&](long i) {
+        return (double) getLineXFromIndex(lanes[i & mask], pp, s.width, xOffsets[i & mask]);
+    });
+
+    add(results, filter, "getTileCoordinates" + suffix, [&](long i) {
+        Point p = getTileCoordinates(lanes[i & mask], s.yLoop + (int) (i & 7), pp, s.width, s.height,
+            xOffsets[i & mask], yOffsets[i & mask], s.yLoop);
+        return (double) (p.x + p.y);
+    });
+
+    // Projecting a frame's lattice, the offsets change every call like they do while playing
+    VertexLattice lattice;
+    add(results, filter, "vertexLatticeUpdate" + suffix, [&](long i) {
+        lattice.update(pp, s.width, s.height, xOffsets[i & mask], yOffsets[i & mask]);
+        return (double) lattice.at(0, 0).x;
+    });
+
+    add(results, filter, "checkShipCollisionWithTile" + suffix, [&](long i) {
+        Index2 tile = track[(int) (i % track.size())];
+        return (double) checkShipCollisionWithTile(shipCenter, tile.x, tile.y, pp, s.width, s.height,
+            xOffsets[i & mask], yOffsets[i & mask], s.yLoop);
+    });
+
+    add(results, filter, "checkShipCollision" + suffix, [&](long i) {
+        return (double) checkShipCollision(track, shipCenter, pp, s.width, s.height,
+            xOffsets[i & mask], yOffsets[i & mask], s.yLoop);
+    });
+
+    // One simulation step's worth of generation, advancing a row every call
+    Track stepTrack;
+    TrackGenerator stepGenerator(42);
+    int stepRow = s.yLoop;
+    int stepLoop = s.yLoop;
+    fillTrack(stepTrack, stepGenerator, stepRow, stepLoop);
+    add(results, filter, "tileGenerationStep" + suffix, [&](long i) {
+        fillTrack(stepTrack, stepGenerator, stepRow, ++stepLoop);
+        return (double) stepTrack.back().x;
+    });
+
+    // Rows requested out of order, each one in a different chunk from the last
+    TrackGenerator randomGenerator(42);
+    add(results, filter, "trackGeneratorRandomRow" + suffix, [&](long i) {
+        TrackRow row = randomGenerator.getRow(s.yLoop + (int) ((i * 7919) & 0xffff));
+        return (double) row.lane;
+    });
+}
+
+// Reads "name,ns" lines written by --save
+static vector<Result> loadBaseline(const char* filename) {
+    vector<Result> baseline;
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Could not open baseline %s\n", filename);
+        return baseline;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        char* comma = strchr(line, ',');
+        if (!comma)
+            continue;
+        *comma = '\0';
+        Result result;
+        result.name = line;
+        result.p50 = atof(comma + 1);
+        result.p10 = result.p90 = result.p50;
+        baseline.push_back(result);
+    }
+
+    fclose(file);
+    return baseline;
+}
+
+static bool saveBaseline(const char* filename, const vector<Result>& results) {
+    FILE* file = fopen(filename, "w");
+    if (!file)
+        return false;
+    for (size_t i = 0; i < results.size(); i++)
+        fprintf(file, "%s,%.4f\n", results[i].name.c_str(), results[i].p50);
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = NULL;
+    const char* saveFile = NULL;
+    const char* baselineFile = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--save") && i + 1 < argc)
+            saveFile = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc)
+            baselineFile = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--filter text] [--save file] [--baseline file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    vector<Result> results;
+    for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++)
+        runScenario(SCENARIOS[i], filter, results);
+
+    vector<Result> baseline;
+    if (baselineFile)
+        baseline = loadBaseline(baselineFile);
+
+    int regressions = 0;
+    printf("%-40s %10s %10s %10s", "benchmark (ns/op)", "p10", "p50", "p90");
+    if (baselineFile)
+        printf(" %10s %8s", "baseline", "change");
+    printf("\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%-40s %10.2f %10.2f %10.2f", r.name.c_str(), r.p10, r.p50, r.p90);
+
+        for (size_t j = 0; j < baseline.size(); j++) {
+            if (baseline[j].name != r.name)
+                continue;
+            double change = r.p50 / baseline[j].p50 - 1;
+            printf(" %10.2f %+7.1f%%", baseline[j].p50, change * 100);
+            if (change > BENCH_THRESHOLD) {
+                printf(" slower");
+                regressions++;
+            }
+            else if (change < -BENCH_THRESHOLD)
+                printf(" faster");
+            break;
+        }
+        printf("\n");
+    }
+
+    if (saveFile && !saveBaseline(saveFile, results)) {
+        fprintf(stderr, "Could not write %s\n", saveFile);
+        return 2;
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+// Replays a recorded game through the headless engine as fast as possible and
+// checks that it reproduces the recorded score and final state.
+//
+// Usage: replay [--repeat n] file.sgr
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include "headlessEngine.h"
+#include "game.h"
+#include "inputRecording.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    const char* filename = NULL;
+    int repeat = 1;
+    bool valid = true;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else if (!filename)
+            filename = argv[i];
+        else
+            valid = false;
+    }
+    if (!valid || !filename || repeat < 1) {
+        fprintf(stderr, "Usage: %s [--repeat n] file.sgr\n", argv[0]);
+        return 2;
+    }
+
+    InputRecording recording;
+    if (!recording.load(filename)) {
+        fprintf(stderr, "Could not read recording %s\n", filename);
+        return 2;
+    }
+    vector<InputFrame> frames = recording.getFrames();
+
+    printf("%s: seed %llu, %d frames in %zu bytes, score %d\n", filename,
+        (unsigned long long) recording.getSeed(), recording.getFrameCount(), recording.getEncodedSize(),
+        recording.getScore());
+
+    bool matches = true;
+    double totalSeconds = 0;
+    for (int run = 0; run < repeat; run++) {
+        HeadlessEngine engine("REPLAY");
+        engine.setRecording(false);
+        engine.setInputScript(frames);
+        engine.setHeldKeys(recording.getInitialKeys());
+
+        GameResources res;
+        res.BG_IMAGE = engine.loadImage("assets/images/bg.png");
+        res.SHIP_IMAGE = engine.loadImage("assets/images/ship.png");
+        res.BTN_BG_IMAGE = engine.loadImage("gfx/lowerBg.png");
+        res.TITLE_FONT = engine.loadFont("assets/fonts/Pirulen.ttf");
+        res.BTN_FONT = engine.loadFont("assets/fonts/Zekton.ttf");
+
+        // Recording the replay again yields its final state hash
+        InputRecording replayed;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int score = startGame(engine, res, recording.getSeed(), &replayed);
+        totalSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if (score != recording.getScore() || replayed.getStateHash() != recording.getStateHash()
+            || replayed.getFrameCount() != recording.getFrameCount()) {
+            printf("run %d diverged: score %d, %d frames, state %016llx, expected state %016llx\n", run,
+                score, replayed.getFrameCount(), (unsigned long long) replayed.getStateHash(),
+                (unsigned long long) recording.getStateHash());
+            matches = false;
+        }
+    }
+
+    double totalFrames = (double) recording.getFrameCount() * repeat;
+    printf("%d run(s) in %.3f ms, %.1f us/frame, %.0f frames/s, %s\n", repeat, totalSeconds * 1000,
+        totalSeconds / totalFrames * 1000000, totalFrames / totalSeconds, matches ? "reproduced" : "DIVERGED");
+    return matches ? 0 : 1;
+}
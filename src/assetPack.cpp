@@ -0,0 +1,217 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "assetPack.h"
+
+#if !defined(__3DS__) && (defined(__unix__) || defined(__APPLE__))
+#define ASSET_PACK_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static_assert(sizeof(AssetEntry) == 92, "The table of contents layout must not depend on the compiler");
+
+AssetPack::AssetPack() : data(nullptr), size(0), mapped(false), entries(nullptr), entryCount(0) {
+#ifdef ASSET_PACK_STREAM
+    file = nullptr;
+#endif
+}
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+int getAssetPixelSize(int32_t format) {
+    // Indexed by raylib PixelFormat, from PIXELFORMAT_UNCOMPRESSED_GRAYSCALE to R32G32B32A32
+    static const int PIXEL_SIZES[] = { 0, 1, 2, 2, 3, 2, 2, 4, 4, 12, 16 };
+    if (format < 0 || format >= (int32_t) (sizeof(PIXEL_SIZES) / sizeof(PIXEL_SIZES[0])))
+        return 0;
+    return PIXEL_SIZES[format];
+}
+
+// Checks that the table of contents of a header lies within a pack of the given size
+static bool isValidHeader(const AssetPackHeader& header, size_t size) {
+    return header.magic == ASSET_PACK_MAGIC && header.version == ASSET_PACK_VERSION
+        && header.tocOffset % ASSET_ALIGNMENT == 0 && header.tocOffset <= size
+        && header.entryCount <= (size - header.tocOffset) / sizeof(AssetEntry);
+}
+
+// Checks that an entry stays within the pack and refers to valid entries
+bool AssetPack::isValidEntry(const AssetEntry& entry) const {
+    if (entry.offset > size || entry.size > size - entry.offset || entry.name[ASSET_NAME_SIZE - 1] != '\0')
+        return false;
+
+    // Texture data is uploaded straight from the pack, so it must hold every pixel
+    if (entry.type == ASSET_TEXTURE) {
+        const AssetTextureInfo& info = entry.texture;
+        int pixelSize = getAssetPixelSize(info.format);
+        return pixelSize > 0 && info.width > 0 && info.height > 0
+            && (uint64_t) info.width * (uint64_t) info.height * pixelSize <= entry.size;
+    }
+
+    int texture = -1;
+    if (entry.type == ASSET_IMAGE)
+        texture = entry.image.texture;
+    else if (entry.type == ASSET_FONT) {
+        texture = entry.font.texture;
+        if (entry.font.glyphCount < 0 || (size_t) entry.font.glyphCount > entry.size / sizeof(AssetGlyph))
+            return false;
+    }
+    else
+        return true;
+
+    if (texture < 0 || texture >= entryCount || entries[texture].type != ASSET_TEXTURE)
+        return false;
+
+    const AssetTextureInfo& info = entries[texture].texture;
+    if (entry.type == ASSET_IMAGE) {
+        return entry.image.x >= 0 && entry.image.y >= 0 && entry.image.width >= 0 && entry.image.height >= 0
+            && entry.image.x + entry.image.width <= info.width && entry.image.y + entry.image.height <= info.height;
+    }
+    return true;
+}
+
+bool AssetPack::open(const char* filename) {
+    close();
+    AssetPackHeader header;
+
+#if defined(ASSET_PACK_MMAP)
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapping = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            data = (const uint8_t*) mapping;
+            size = (size_t) info.st_size;
+            mapped = true;
+        }
+    }
+    ::close(fd);
+#elif defined(ASSET_PACK_STREAM)
+    file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    // Only the header and the table of contents are read now, entries are read as they are loaded
+    long length = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (length >= (long) sizeof(header) && fseek(file, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, file) == 1
+        && isValidHeader(header, (size_t) length)) {
+        size_t tocSize = header.entryCount * sizeof(AssetEntry);
+        uint8_t* toc = (uint8_t*) malloc(tocSize > 0 ? tocSize : 1);
+        if (toc && fseek(file, (long) header.tocOffset, SEEK_SET) == 0 && fread(toc, 1, tocSize, file) == tocSize) {
+            data = toc;
+            size = (size_t) length;
+        }
+        else
+            free(toc);
+    }
+    if (!data) {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+#else
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    // Read the whole pack at once, the assets are stored in the order they are loaded
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        uint8_t* buffer = length > 0 ? (uint8_t*) malloc((size_t) length) : nullptr;
+        if (buffer && fseek(file, 0, SEEK_SET) == 0 && fread(buffer, 1, (size_t) length, file) == (size_t) length) {
+            data = buffer;
+            size = (size_t) length;
+        }
+        else
+            free(buffer);
+    }
+    fclose(file);
+#endif
+
+    if (!data)
+        return false;
+
+    // Validate the header and the table of contents before handing out any entry
+#ifdef ASSET_PACK_STREAM
+    bool valid = true;
+    entries = (const AssetEntry*) data;
+    entryCount = (int) header.entryCount;
+#else
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        valid = isValidHeader(header, size);
+    }
+    if (valid) {
+        entries = (const AssetEntry*) (data + header.tocOffset);
+        entryCount = (int) header.entryCount;
+    }
+#endif
+    for (int i = 0; i < entryCount && valid; i++)
+        valid = isValidEntry(entries[i]);
+
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    if (data) {
+#ifdef ASSET_PACK_MMAP
+        if (mapped)
+            munmap((void*) data, size);
+#endif
+        if (!mapped)
+            free((void*) data);
+    }
+#ifdef ASSET_PACK_STREAM
+    if (file)
+        fclose(file);
+    file = nullptr;
+#endif
+
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    entries = nullptr;
+    entryCount = 0;
+}
+
+bool AssetPack::isOpen() const {
+    return data != nullptr;
+}
+
+int AssetPack::getEntryCount() const {
+    return entryCount;
+}
+
+const AssetEntry& AssetPack::getEntry(int index) const {
+    return entries[index];
+}
+
+int AssetPack::find(const char* name, uint32_t type) const {
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].type == type && strcmp(entries[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+#ifdef ASSET_PACK_STREAM
+FILE* AssetPack::seekData(const AssetEntry& entry) {
+    return fseek(file, (long) entry.offset, SEEK_SET) == 0 ? file : nullptr;
+}
+#else
+const void* AssetPack::getData(const AssetEntry& entry) const {
+    return data + entry.offset;
+}
+#endif
@@ -0,0 +1,130 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+#define ASSET_PACK_MAGIC 0x4b504753 // "SGPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_NAME_SIZE 56
+#define ASSET_ALIGNMENT 16 // Data of every entry starts at a multiple of this
+
+#ifdef __3DS__
+#define ASSET_PACK_FILE "romfs:/starglide.pak"
+#define ASSET_PACK_STREAM   // Entries are read from the file into where they are loaded to
+#else
+#define ASSET_PACK_FILE "assets/starglide.pak"
+#endif
+
+// Kinds of entries in an asset pack
+enum AssetType {
+    ASSET_TEXTURE = 1,  // Decoded pixels, ready to upload
+    ASSET_IMAGE = 2,    // Rectangle of a texture entry, no data of its own
+    ASSET_FONT = 3,     // Baked glyphs, an array of AssetGlyph, drawn from a texture entry
+    ASSET_BLOB = 4      // File stored as is, such as a t3x sheet or bcfnt font for the 3DS
+};
+
+struct AssetTextureInfo {
+    int32_t width;
+    int32_t height;
+    int32_t format;     // raylib PixelFormat of the data
+};
+
+struct AssetImageInfo {
+    int32_t texture;    // Index of the texture entry
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
+struct AssetFontInfo {
+    int32_t baseSize;
+    int32_t glyphCount;
+    int32_t glyphPadding;
+    int32_t texture;    // Index of the texture entry holding the glyph atlas
+};
+
+struct AssetGlyph {
+    int32_t value;      // Codepoint
+    int32_t offsetX;
+    int32_t offsetY;
+    int32_t advanceX;
+    float x;            // Rectangle of the glyph in the font texture
+    float y;
+    float width;
+    float height;
+};
+
+// Table of contents entry, the table is an array of these at tocOffset
+struct AssetEntry {
+    char name[ASSET_NAME_SIZE];     // Path the asset is requested by, such as "assets/images/bg.png"
+    uint32_t type;
+    uint32_t offset;                // Byte range of the data within the pack
+    uint32_t size;
+    union {
+        AssetTextureInfo texture;
+        AssetImageInfo image;
+        AssetFontInfo font;
+        int32_t reserved[6];
+    };
+};
+
+// Returns the bytes per pixel of a texture format, 0 for formats a pack may not hold.
+// Packs only hold the uncompressed raylib formats, whose values are stable across versions
+int getAssetPixelSize(int32_t format);
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t tocOffset;
+};
+
+// Read-only view of a pack built by tools/packAssets. The file is memory-mapped
+// where the platform supports it, otherwise read into memory in one sequential
+// pass, and entry data is handed out as pointers into it without copying.
+// On 3DS every entry is copied into linear memory when it is loaded, so only the
+// table of contents is read and the entries are streamed from the open file
+class AssetPack {
+public:
+    AssetPack();
+    ~AssetPack();
+
+    // Opens and validates a pack, returns false if it is missing or invalid
+    bool open(const char* filename);
+    void close();
+    bool isOpen() const;
+
+    int getEntryCount() const;
+    const AssetEntry& getEntry(int index) const;
+    // Returns the index of the entry with the given name and type, or -1
+    int find(const char* name, uint32_t type) const;
+#ifdef ASSET_PACK_STREAM
+    // Positions the pack file at the data of an entry and returns it, null if the seek fails.
+    // The file stays owned by the pack, it is valid until the next call or until the pack is closed
+    FILE* seekData(const AssetEntry& entry);
+#else
+    // Returns the data of an entry, valid until the pack is closed
+    const void* getData(const AssetEntry& entry) const;
+#endif
+
+private:
+    const uint8_t* data;        // Whole pack, or only the table of contents when streaming
+    size_t size;                // Size of the pack file
+    bool mapped;
+    const AssetEntry* entries;
+    int entryCount;
+#ifdef ASSET_PACK_STREAM
+    FILE* file;
+#endif
+
+    bool isValidEntry(const AssetEntry& entry) const;
+
+    // Packs are not copyable, they own their mapping
+    AssetPack(const AssetPack&);
+    AssetPack& operator=(const AssetPack&);
+};
+
+#endif // ASSETPACK_H
@@ -0,0 +1,53 @@
+#include <algorithm>
+
+#include "atlas.h"
+
+using namespace std;
+
+vector<AtlasSize> packAtlas(const vector<AtlasSize>& sizes, int maxSize, int padding, vector<AtlasRect>& rects) {
+    vector<AtlasSize> pages;
+    rects.assign(sizes.size(), AtlasRect());
+
+    // Taller images first, so each shelf wastes little height
+    vector<int> order(sizes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int) i;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return sizes[a].height > sizes[b].height;
+    });
+
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        const AtlasSize& size = sizes[order[i]];
+
+        // An image that does not fit any page gets one of its own
+        if (size.width > maxSize || size.height > maxSize) {
+            rects[order[i]] = { (int) pages.size(), 0, 0, size.width, size.height };
+            pages.push_back(size);
+            shelfX = shelfY = shelfHeight = maxSize;
+            continue;
+        }
+
+        // Start a new shelf when the row is full, and a new page when the shelves are
+        if (pages.empty() || shelfX + size.width > maxSize) {
+            shelfY += shelfHeight + padding;
+            shelfX = 0;
+            shelfHeight = size.height;
+        }
+        if (pages.empty() || shelfY + size.height > maxSize) {
+            pages.push_back({ 0, 0 });
+            shelfX = shelfY = 0;
+            shelfHeight = size.height;
+        }
+
+        AtlasSize& page = pages.back();
+        rects[order[i]] = { (int) pages.size() - 1, shelfX, shelfY, size.width, size.height };
+        page.width = max(page.width, shelfX + size.width);
+        page.height = max(page.height, shelfY + size.height);
+        shelfX += size.width + padding;
+    }
+
+    return pages;
+}
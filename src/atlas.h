@@ -0,0 +1,30 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <vector>
+
+#define ATLAS_MAX_SIZE 4096 // Largest page side, images larger than this get a page of their own
+#define ATLAS_PADDING 2     // Empty pixels kept between images so filtering does not bleed
+
+using namespace std;
+
+struct AtlasSize {
+    int width;
+    int height;
+};
+
+// Where an image was placed: its page and its rectangle within that page
+struct AtlasRect {
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Packs rectangles into as few pages as possible using shelves filled in order of
+// decreasing height. rects receives the placement of each size, in input order, and
+// the returned vector holds the size of each page, trimmed to the space used
+vector<AtlasSize> packAtlas(const vector<AtlasSize>& sizes, int maxSize, int padding, vector<AtlasRect>& rects);
+
+#endif // ATLAS_H
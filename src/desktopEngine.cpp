@@ -1,30 +1,34 @@
 #include <algorithm> 
 #include <cmath>    
 #include <iostream>
+#include <cstring>
+#include <rlgl.h>
 
 #include "colors.h"
 #include "keys.h"
 #include "desktopEngine.h"
+#include "profiler.h"
 
 #define WINDOW_WIDTH 900
 #define WINDOW_HEIGHT 400
+#define BATCH_CHUNK_VERTICES 1536   // Vertices checked against the rlgl batch limit at a time
 
 using namespace std;
 
 // Helper function to calculate the signed area of a triangle
-double signedArea(Point p1, Point p2, Point p3) {
+double signedArea(Vector2 p1, Vector2 p2, Vector2 p3) {
     return (p2.x - p1.x) * (p3.y - p1.y) - (p2.y - p1.y) * (p3.x - p1.x);
 }
 
 // Function to determine if points are in clockwise order
-bool isClockwise(Point p1, Point p2, Point p3, Point p4) {
+bool isClockwise(Vector2 p1, Vector2 p2, Vector2 p3, Vector2 p4) {
     double area1 = signedArea(p1, p2, p3);
     double area2 = signedArea(p1, p3, p4);
     return (area1 + area2) < 0;
 }
 
 // Function to sort the points into the correct order
-void sortPoints(Point& p1, Point& p2, Point& p3, Point& p4) {
+void sortPoints(Vector2& p1, Vector2& p2, Vector2& p3, Vector2& p4) {
     // Check for all possible point arrangements and reorder them
     if (!isClockwise(p1, p2, p3, p4)) {
         // If not in clockwise order, swap p3 and p4
@@ -43,11 +47,22 @@ void sortPoints(Point& p1, Point& p2, Point& p3, Point& p4) {
     }
 }
 
+static Color toColor(RGB_Color color) {
+    return { color.r, color.g, color.b, color.a };
+}
+
+static Vector2 toVector(DrawVertex v) {
+    return { v.x, v.y };
+}
+
 
 DesktopEngine::DesktopEngine(const char* title) : GameEngine(title) {
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, title);  // Initialize window with title
     SetTargetFPS(60);  // Set frame rate to 60 FPS
+
+    for (LayerCache& cache : layerCaches)
+        cache.layer = -1;
 }
 
 DesktopEngine::~DesktopEngine() {
@@ -63,120 +78,293 @@ void DesktopEngine::terminateGame() {
     gameIsTerminated = true;
 }
 
-void DesktopEngine::startDrawing() {
-    BeginDrawing();  // Start drawing
+void DesktopEngine::renderFrame(const DrawCommandBuffer& commands, bool lowerScreen) {
+    // The desktop has no lower screen, its draw calls are discarded
+    if (lowerScreen)
+        return;
+
+    if (!pendingImages.empty())
+        buildAtlas();
+
+    // Cached runs that changed are rendered to their targets before the screen is bound
+    findCachedSpans(commands, cachedSpans);
+    for (const CachedSpan& span : cachedSpans)
+        updateLayerCache(commands, span);
+
+    BeginDrawing();
+    size_t nextSpan = 0;
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (nextSpan < cachedSpans.size() && i == cachedSpans[nextSpan].begin) {
+            const CachedSpan& span = cachedSpans[nextSpan++];
+            LayerCache* cache = getLayerCache(span.layer);
+
+            // Without a free target the run is drawn directly
+            if (cache) {
+                Texture2D texture = cache->target.texture;
+                Rectangle sourceRect = { 0, 0, (float) texture.width, (float) -texture.height };
+
+                BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+                DrawTextureRec(texture, sourceRect, { 0, 0 }, WHITE);
+                EndBlendMode();
+                i = span.end - 1;
+                continue;
+            }
+        }
+        renderCommand(commands, commands[i]);
+    }
+    EndDrawing();
 }
 
-void DesktopEngine::clearBackground(RGB_Color color) {
-    if (drawing)
-        ClearBackground({ color.r, color.g, color.b, color.a});  // Clear screen with specified color
+void DesktopEngine::skipFrame(bool lowerScreen) {
+    // EndDrawing is what polls input, in idle rendering this blocks until an event arrives
+    if (!lowerScreen)
+        PollInputEvents();
 }
 
-void DesktopEngine::drawRect(Point p, double width, double height, RGB_Color fill) {
-    if (drawing)
-        DrawRectangle((int) p.x, (int) p.y, (int) width, (int) height, { fill.r, fill.g, fill.b, fill.a });
+void DesktopEngine::setIdleRendering(bool idle) {
+    GameEngine::setIdleRendering(idle);
+    if (idle)
+        EnableEventWaiting();
+    else
+        DisableEventWaiting();
 }
 
-void DesktopEngine::drawLine(Point start, Point end, RGB_Color color) {
-    if (drawing)
-        DrawLine((int) start.x, (int) start.y, (int) end.x, (int) end.y, { color.r, color.g, color.b, color.a });
+// Returns the target of the run starting at a layer, sized to the window
+LayerCache* DesktopEngine::getLayerCache(int layer) {
+    LayerCache* cache = nullptr;
+    for (LayerCache& slot : layerCaches) {
+        if (slot.layer == layer)
+            return &slot;
+        if (!cache && slot.layer == -1)
+            cache = &slot;
+    }
+    if (!cache)
+        return nullptr;
+
+    cache->layer = layer;
+    cache->valid = false;
+    return cache;
 }
 
-void DesktopEngine::drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill) {
+void DesktopEngine::updateLayerCache(const DrawCommandBuffer& commands, const CachedSpan& span) {
+    LayerCache* cache = getLayerCache(span.layer);
+    if (!cache)
+        return;
+
+    // A resized window needs a new target
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    if (cache->valid && (cache->target.texture.width != width || cache->target.texture.height != height)) {
+        resources.unreserve(MEMORY_VRAM, (size_t) cache->target.texture.width * cache->target.texture.height * 4);
+        UnloadRenderTexture(cache->target);
+        cache->valid = false;
+    }
+    else if (cache->valid && cache->hash == span.hash) {
+        return;
+    }
+    if (!cache->valid) {
+        cache->target = LoadRenderTexture(width, height);
+        resources.reserve(MEMORY_VRAM, (size_t) width * height * 4);
+    }
+
+    // Colors are blended as usual but alpha accumulates as coverage, leaving premultiplied
+    // colors that composite exactly like drawing the commands straight to the screen
+    BeginTextureMode(cache->target);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA,
+        RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    for (size_t i = span.begin; i < span.end; i++)
+        renderCommand(commands, commands[i]);
+    EndBlendMode();
+    EndTextureMode();
+
+    cache->hash = span.hash;
+    cache->valid = true;
+}
+
+void DesktopEngine::renderCommand(const DrawCommandBuffer& commands, const DrawCommand& command) {
+    Color color = toColor(command.color);
+
+    switch (command.type) {
+    case CMD_CLEAR:
+        ClearBackground(color);
+        break;
+    case CMD_RECT:
+        DrawRectangle((int) command.v[0].x, (int) command.v[0].y, (int) command.v[1].x, (int) command.v[1].y,
+            color);
+        break;
+    case CMD_LINE:
+        DrawLine((int) command.v[0].x, (int) command.v[0].y, (int) command.v[1].x, (int) command.v[1].y,
+            color);
+        break;
+    case CMD_TRIANGLE:
+        renderTriangle(command);
+        break;
+    case CMD_QUAD:
+        renderQuad(command);
+        break;
+    case CMD_LINES:
+    case CMD_QUADS:
+    case CMD_MESH:
+        renderBatch(commands, command);
+        break;
+    case CMD_IMAGE:
+        renderImage(command);
+        break;
+    case CMD_TEXT:
+        renderText(command, commands.getText(command));
+        break;
+    }
+}
+
+void DesktopEngine::renderTriangle(const DrawCommand& command) {
+    Vector2 p1 = toVector(command.v[0]);
+    Vector2 p2 = toVector(command.v[1]);
+    Vector2 p3 = toVector(command.v[2]);
+
     // Check if the points are in counterclockwise order
     if (signedArea(p1, p2, p3) >= 0) {
         // Swap p2 and p3 to ensure counterclockwise order
-        Point temp = p2;
-        p2 = p3;
-        p3 = temp;
+        swap(p2, p3);
     }
 
-    if (drawing)
-        DrawTriangle(
-            { (float) p1.x, (float) p1.y },
-            { (float) p2.x, (float) p2.y },
-            { (float) p3.x, (float) p3.y },
-            { fill.r, fill.g, fill.b, fill.a }
-        );
+    DrawTriangle(p1, p2, p3, toColor(command.color));
 }
 
-void DesktopEngine::drawQuad(Point p1, Point p2, Point p3, Point p4, RGB_Color fill) {
+void DesktopEngine::renderQuad(const DrawCommand& command) {
+    Vector2 p1 = toVector(command.v[0]);
+    Vector2 p2 = toVector(command.v[1]);
+    Vector2 p3 = toVector(command.v[2]);
+    Vector2 p4 = toVector(command.v[3]);
+    Color fill = toColor(command.color);
+
     // Sort the points into the correct order
     sortPoints(p1, p2, p3, p4);
 
-    // Draw the first triangle (p1, p2, p3)
-    if (drawing)
-        DrawTriangle(
-            { (float) p1.x, (float) p1.y },
-            { (float) p2.x, (float) p2.y },
-            { (float) p3.x, (float) p3.y },
-            { fill.r, fill.g, fill.b, fill.a }
-        );
-
-    // Draw the second triangle (p1, p3, p4)
-    if (drawing)
-        DrawTriangle(
-            { (float) p1.x, (float) p1.y },
-            { (float) p3.x, (float) p3.y },
-            { (float) p4.x, (float) p4.y },
-            { fill.r, fill.g, fill.b, fill.a }
-        );
+    // Draw the first triangle (p1, p2, p3) and the second triangle (p1, p3, p4)
+    DrawTriangle(p1, p2, p3, fill);
+    DrawTriangle(p1, p3, p4, fill);
 }
 
-void DesktopEngine::endDrawing() {
-    EndDrawing();  // End drawing
+// Signed area of a triangle of a batch, rlgl culls triangles where it is not negative
+static float batchArea(const DrawVertex& a, const DrawVertex& b, const DrawVertex& c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
 }
 
-void DesktopEngine::freeResources() {
-    // Clear textures
-    for (Texture2D& texture : textures) {
-        UnloadTexture(texture); 
+// Submits a batched primitive straight to rlgl. Culling stays on, rlgl only draws its buffered
+// vertices later, so the winding is fixed as each triangle is emitted, once per convex quad
+void DesktopEngine::renderBatch(const DrawCommandBuffer& commands, const DrawCommand& command) {
+    if (command.vertexCount == 0)
+        return;
+
+    const DrawVertex* vertices = commands.getVertices(command);
+    const RGB_Color* colors = commands.getVertexColors(command);
+    const uint16_t* indices = command.indexCount > 0 ? commands.getIndices(command) : nullptr;
+
+    // Each batch is emitted as a list of vertices of the rlgl primitive
+    int mode = command.type == CMD_LINES ? RL_LINES : RL_TRIANGLES;
+    int primitiveVertices = command.type == CMD_QUADS ? 4 : command.type == CMD_LINES ? 2 : 3;
+    int noPrimitives = command.type == CMD_MESH ? command.indexCount / 3 : command.vertexCount / primitiveVertices;
+    int emittedVertices = command.type == CMD_QUADS ? 6 : primitiveVertices;
+    int chunkSize = BATCH_CHUNK_VERTICES / emittedVertices;
+
+    // Lines match DrawLine, which snaps to pixel centres
+    float offset = command.type == CMD_LINES ? 0.5f : 0.0f;
+    static const int QUAD_ORDER[2][6] = { { 0, 1, 2, 0, 2, 3 }, { 0, 2, 1, 0, 3, 2 } };
+    static const int TRIANGLE_ORDER[2][3] = { { 0, 1, 2 }, { 0, 2, 1 } };
+
+    for (int first = 0; first < noPrimitives; first += chunkSize) {
+        int last = min(noPrimitives, first + chunkSize);
+        rlCheckRenderBatchLimit((last - first) * emittedVertices);
+        rlSetTexture(0);
+        rlBegin(mode);
+        for (int p = first; p < last; p++) {
+            // Triangles wound the way rlgl culls are emitted the other way round
+            int reversed = 0;
+            if (command.type == CMD_MESH) {
+                reversed = batchArea(vertices[indices[3 * p]], vertices[indices[3 * p + 1]],
+                    vertices[indices[3 * p + 2]]) >= 0;
+            } else if (command.type == CMD_QUADS) {
+                // Both halves, a quad squashed near the horizon may have a degenerate one
+                const DrawVertex* q = &vertices[4 * p];
+                reversed = batchArea(q[0], q[1], q[2]) + batchArea(q[0], q[2], q[3]) >= 0;
+            }
+
+            for (int k = 0; k < emittedVertices; k++) {
+                int i;
+                if (command.type == CMD_MESH)
+                    i = indices[3 * p + TRIANGLE_ORDER[reversed][k]];
+                else if (command.type == CMD_QUADS)
+                    i = 4 * p + QUAD_ORDER[reversed][k];
+                else
+                    i = 2 * p + k;
+
+                rlColor4ub(colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+                if (offset != 0.0f)
+                    rlVertex2f((int) vertices[i].x + offset, (int) vertices[i].y + offset);
+                else
+                    rlVertex2f(vertices[i].x, vertices[i].y);
+            }
+        }
+        rlEnd();
     }
-    textures.clear();
 }
 
-// Function to calculate the difference between two sets of keys
-vector<Key> minusSets(const vector<Key>& a, const vector<Key>& b) {
-    vector<Key> result;
-    for (const Key& key : a) {
-        if (find(b.begin(), b.end(), key) == b.end()) {
-            result.push_back(key);
-        }
+void DesktopEngine::freeResources() {
+    // Clear textures, pages whose images were all released are already unloaded
+    for (Texture2D& texture : atlasPages) {
+        if (texture.id != 0)
+            UnloadTexture(texture); 
+    }
+    atlasPages.clear();
+    pageImages.clear();
+    for (Image& image : pendingImages) {
+        UnloadImage(image);
+    }
+    pendingImages.clear();
+    pendingSlots.clear();
+    imageRects.clear();
+
+    // Clear fonts
+    for (int slot = 0; slot < (int) fonts.size(); slot++) {
+        if (resources.isUsed(slot, RESOURCE_FONT))
+            unloadFont(slot);
+    }
+    fonts.clear();
+    textCache.clear();
+    resources.clear();
+
+    // Clear cached layers
+    for (LayerCache& cache : layerCaches) {
+        if (cache.valid)
+            UnloadRenderTexture(cache.target);
+        cache.layer = -1;
+        cache.valid = false;
     }
-    return result;
 }
 
 void DesktopEngine::scanInput() {
-    vector<Key> prevHeldKeys = heldKeys;
-    heldKeys = calcHeldKeys();
-    releasedKeys = minusSets(prevHeldKeys, heldKeys);
+    input.update(calcHeldKeys());
 }
 
-const vector<Key> DesktopEngine::calcHeldKeys() {
-    vector<Key> keyVector;
+uint32_t DesktopEngine::calcHeldKeys() {
+    uint32_t keys = 0;
     if (IsKeyDown(KeyboardKey::KEY_W))
-        keyVector.push_back(UP_KEY);
+        keys |= KEY_BIT(UP_KEY);
     if (IsKeyDown(KeyboardKey::KEY_S))
-        keyVector.push_back(DOWN_KEY);
+        keys |= KEY_BIT(DOWN_KEY);
     if (IsKeyDown(KeyboardKey::KEY_A))
-        keyVector.push_back(LEFT_KEY);
+        keys |= KEY_BIT(LEFT_KEY);
     if (IsKeyDown(KeyboardKey::KEY_D))
-        keyVector.push_back(RIGHT_KEY);
+        keys |= KEY_BIT(RIGHT_KEY);
     if (IsKeyDown(KeyboardKey::KEY_ENTER))
-        keyVector.push_back(START_KEY);
+        keys |= KEY_BIT(START_KEY);
     if (IsKeyDown(KeyboardKey::KEY_BACKSPACE))
-        keyVector.push_back(SELECT_KEY);
+        keys |= KEY_BIT(SELECT_KEY);
     if (IsKeyDown(KeyboardKey::KEY_SPACE))
-        keyVector.push_back(PRIMARY_KEY);
-    return keyVector;
-}
-
-const vector<Key> DesktopEngine::getReleasedKeys() {
-    return releasedKeys;
-}
-
-const vector<Key> DesktopEngine::getHeldKeys() {
-    return heldKeys;
+        keys |= KEY_BIT(PRIMARY_KEY);
+    return keys;
 }
 
 // Returns the (x, y) coordinates as a percentage of touchscreen
@@ -223,8 +411,8 @@ Point DesktopEngine::getTouchDragged() {
     Point currentPosition = getTouchHeldPosition();
 
     // Calculate the change in position as percentages
-    double deltaX = currentPosition.x - previousPosition.x;
-    double deltaY = currentPosition.y - previousPosition.y;
+    double deltaX = (double) (currentPosition.x - previousPosition.x);
+    double deltaY = (double) (currentPosition.y - previousPosition.y);
 
     // If the current position is {-1, -1}, return {0, 0} to indicate no movement
     if (currentPosition.x == -1 || previousPosition.x == -1) {
@@ -248,66 +436,312 @@ int DesktopEngine::getScreenHeight() {
     return GetScreenHeight();
 }
 
+void DesktopEngine::closeAssetPack() {
+    packTextures.clear();
+    GameEngine::closeAssetPack();
+}
+
+// Uploads a texture straight from the pack's memory
+Texture2D DesktopEngine::loadPackTexture(const AssetEntry& entry) {
+    Image image = { (void*) assetPack.getData(entry), entry.texture.width, entry.texture.height, 1,
+        entry.texture.format };
+    return LoadTextureFromImage(image);
+}
+
+// Returns the atlas page of a pack texture entry, uploading it the first time
+int DesktopEngine::getPackTexture(int entry) {
+    if (packTextures.empty())
+        packTextures.assign(assetPack.getEntryCount(), -1);
+
+    if (packTextures[entry] < 0)
+        packTextures[entry] = addAtlasPage(loadPackTexture(assetPack.getEntry(entry)));
+    return packTextures[entry];
+}
+
+// Adds an uploaded page and charges it to video memory, its images are counted as they are added
+int DesktopEngine::addAtlasPage(Texture2D texture) {
+    atlasPages.push_back(texture);
+    pageImages.push_back(0);
+    resources.reserve(MEMORY_VRAM, GetPixelDataSize(texture.width, texture.height, texture.format));
+    return (int) atlasPages.size() - 1;
+}
+
+// Images share their atlas pages, so they are never evicted. Only the pages are charged
 int DesktopEngine::loadImage(const string& filename) {
-    Texture2D texture = LoadTexture(filename.c_str());
+    // Images in the pack are already decoded and packed into atlas pages
+    int entry = assetPack.isOpen() ? assetPack.find(filename.c_str(), ASSET_IMAGE) : -1;
+    if (entry >= 0) {
+        int id = resources.create(RESOURCE_IMAGE, false);
+        if (id < 0)
+            return -1;
+
+        const AssetImageInfo& info = assetPack.getEntry(entry).image;
+        int slot = resources.resolve(id, RESOURCE_IMAGE);
+        int page = getPackTexture(info.texture);
+        imageRects.resize(resources.getSlotCount());
+        imageRects[slot] = { page, info.x, info.y, info.width, info.height };
+        pageImages[page]++;
+        resources.setLoaded(slot, 0, 0);
+        return id;
+    }
+
+    Image image = LoadImage(filename.c_str());
 
-    // Check if the texture was successfully loaded
-    if (texture.width == 0 && texture.height == 0) {
-        // Texture loading failed, return -1
+    // Check if the image was successfully loaded
+    if (image.data == nullptr) {
+        // Image loading failed, return -1
         return -1;
     }
+    int id = resources.create(RESOURCE_IMAGE, false);
+    if (id < 0) {
+        UnloadImage(image);
+        return -1;
+    }
+
+    // The image is kept in memory until the atlas it goes into is built
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    int slot = resources.resolve(id, RESOURCE_IMAGE);
+    pendingImages.push_back(image);
+    pendingSlots.push_back(slot);
+    imageRects.resize(resources.getSlotCount());
+    imageRects[slot] = AtlasRect();
+    resources.setLoaded(slot, 0, (size_t) image.width * image.height * 4);
+    return id;
+}
+
+// Frees a released image, and its atlas page once no image on it is left
+void DesktopEngine::releaseImage(int slot) {
+    for (size_t i = 0; i < pendingSlots.size(); i++) {
+        if (pendingSlots[i] == slot) {
+            UnloadImage(pendingImages[i]);
+            pendingImages.erase(pendingImages.begin() + i);
+            pendingSlots.erase(pendingSlots.begin() + i);
+            return;
+        }
+    }
+
+    int page = imageRects[slot].page;
+    if (--pageImages[page] > 0)
+        return;
+
+    Texture2D& texture = atlasPages[page];
+    resources.unreserve(MEMORY_VRAM, GetPixelDataSize(texture.width, texture.height, texture.format));
+    UnloadTexture(texture);
+    texture = Texture2D();
+
+    // A pack texture is uploaded again if an image on it is loaded later
+    for (int& packPage : packTextures) {
+        if (packPage == page)
+            packPage = -1;
+    }
+}
+
+// Packs the images loaded since the last build into new atlas pages
+void DesktopEngine::buildAtlas() {
+    vector<AtlasSize> sizes;
+    for (const Image& image : pendingImages)
+        sizes.push_back({ image.width, image.height });
+
+    vector<AtlasRect> rects;
+    vector<AtlasSize> pageSizes = packAtlas(sizes, ATLAS_MAX_SIZE, ATLAS_PADDING, rects);
+
+    int firstPage = (int) atlasPages.size();
+    for (size_t page = 0; page < pageSizes.size(); page++) {
+        Image pageImage = GenImageColor(pageSizes[page].width, pageSizes[page].height, BLANK);
+
+        // Copy the pixels row by row, both images are RGBA8
+        for (size_t i = 0; i < pendingImages.size(); i++) {
+            const AtlasRect& rect = rects[i];
+            if (rect.page != (int) page)
+                continue;
+
+            const unsigned char* source = (const unsigned char*) pendingImages[i].data;
+            unsigned char* target = (unsigned char*) pageImage.data;
+            for (int y = 0; y < rect.height; y++) {
+                memcpy(target + ((size_t) (rect.y + y) * pageImage.width + rect.x) * 4,
+                    source + (size_t) y * rect.width * 4, (size_t) rect.width * 4);
+            }
+        }
+
+        addAtlasPage(LoadTextureFromImage(pageImage));
+        UnloadImage(pageImage);
+    }
 
-    textures.push_back(texture);
-    return (int) textures.size() - 1;
+    // The pixels now live in the pages, so the images no longer hold any memory
+    for (size_t i = 0; i < pendingImages.size(); i++) {
+        int slot = pendingSlots[i];
+        imageRects[slot] = rects[i];
+        imageRects[slot].page += firstPage;
+        pageImages[imageRects[slot].page]++;
+        resources.setLoaded(slot, 0, 0);
+        UnloadImage(pendingImages[i]);
+    }
+    pendingImages.clear();
+    pendingSlots.clear();
 }
 
-void DesktopEngine::drawImage(int id, Point p, double width, double height) {
-    if (drawing) {
-        Texture2D texture = textures[id];
-        Rectangle sourceRect = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-        Rectangle destRect = { (float)p.x, (float)p.y, (float)width, (float)height };
-        Vector2 origin = { 0.0f, 0.0f };
+void DesktopEngine::renderImage(const DrawCommand& command) {
+    // The image may have been released after it was drawn
+    if (!resources.isUsed(command.id, RESOURCE_IMAGE))
+        return;
+
+    const AtlasRect& rect = imageRects[command.id];
+    Texture2D texture = atlasPages[rect.page];
+    Rectangle sourceRect = { (float) rect.x, (float) rect.y, (float) rect.width, (float) rect.height };
+    Rectangle destRect = { command.v[0].x, command.v[0].y, command.v[1].x, command.v[1].y };
+    Vector2 origin = { 0.0f, 0.0f };
 
-        DrawTexturePro(texture, sourceRect, destRect, origin, 0.0f, WHITE);
+    DrawTexturePro(texture, sourceRect, destRect, origin, 0.0f, WHITE);
+}
+
+// Creates a font from glyphs baked into the pack
+Font DesktopEngine::loadPackFont(const AssetEntry& entry) {
+    const AssetFontInfo& info = entry.font;
+    const AssetGlyph* glyphs = (const AssetGlyph*) assetPack.getData(entry);
+
+    Font font = {};
+    font.baseSize = info.baseSize;
+    font.glyphCount = info.glyphCount;
+    font.glyphPadding = info.glyphPadding;
+    font.texture = loadPackTexture(assetPack.getEntry(info.texture));
+    SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+
+    // raylib owns and frees these arrays, so they are the only part that is copied
+    font.recs = (Rectangle*) MemAlloc(info.glyphCount * sizeof(Rectangle));
+    font.glyphs = (GlyphInfo*) MemAlloc(info.glyphCount * sizeof(GlyphInfo));
+    for (int i = 0; i < info.glyphCount; i++) {
+        font.recs[i] = { glyphs[i].x, glyphs[i].y, glyphs[i].width, glyphs[i].height };
+        font.glyphs[i].value = glyphs[i].value;
+        font.glyphs[i].offsetX = glyphs[i].offsetX;
+        font.glyphs[i].offsetY = glyphs[i].offsetY;
+        font.glyphs[i].advanceX = glyphs[i].advanceX;
     }
+    return font;
 }
 
+// Fonts can be evicted, their buckets are loaded again when next drawn
 int DesktopEngine::loadFont(const string& filename) {
-    Font font = LoadFontEx(filename.c_str(), getScreenHeight(), nullptr, 0);
-    fonts.push_back(font);
-    return (int) fonts.size() - 1;
-}
-
-void DesktopEngine::drawText(int id, const string& text, Point p, bool center, double fontSize,
-    double spacing, RGB_Color color) {
-    if (drawing) {
-        Font font = fonts[id];
-        Vector2 textPosition;
-
-        if (center) {
-            // Measure the text size
-            Vector2 textSize = MeasureTextEx(font, text.c_str(), (float)fontSize, (float)spacing);
-
-            // Calculate the position to center the text
-            textPosition = {
-                (float)p.x - (textSize.x / 2),
-                (float)p.y - (textSize.y / 2)
-            };
-        } else {
-            textPosition = { (float) p.x, (float) p.y };
+    int id = resources.create(RESOURCE_FONT, true);
+    if (id < 0)
+        return -1;
+
+    int slot = resources.resolve(id, RESOURCE_FONT);
+    fonts.resize(resources.getSlotCount());
+    FontFace& face = fonts[slot];
+    face.filename = filename;
+    face.fileData = nullptr;
+    face.fileSize = 0;
+
+    // Buckets baked into the pack are loaded now, the others are rasterized when first drawn
+    for (int i = 0; i < NO_FONT_BUCKETS; i++) {
+        int entry = assetPack.isOpen() ? assetPack.find(getFontBucketName(filename, i).c_str(), ASSET_FONT) : -1;
+        face.loaded[i] = entry >= 0;
+        if (face.loaded[i])
+            face.buckets[i] = loadPackFont(assetPack.getEntry(entry));
+    }
+    chargeFont(slot);
+    return id;
+}
+
+// Loads the bucket of a font size as the text is drawn, so no font is rasterized during a frame
+bool DesktopEngine::loadFontSize(int slot, float fontSize) {
+    FontFace& face = fonts[slot];
+    int bucket = getFontBucket(fontSize);
+    if (face.loaded[bucket])
+        return true;
+
+    // A bucket evicted with the pack still open is taken from the pack again
+    int entry = assetPack.isOpen() ? assetPack.find(getFontBucketName(face.filename, bucket).c_str(),
+        ASSET_FONT) : -1;
+    if (entry >= 0) {
+        face.buckets[bucket] = loadPackFont(assetPack.getEntry(entry));
+    } else {
+        if (!face.fileData)
+            face.fileData = LoadFileData(face.filename.c_str(), &face.fileSize);
+        if (!face.fileData)
+            return false;
+
+        vector<int> codepoints = getFontCodepoints();
+        face.buckets[bucket] = LoadFontFromMemory(".ttf", face.fileData, face.fileSize,
+            FONT_BUCKET_SIZES[bucket], codepoints.data(), (int) codepoints.size());
+        SetTextureFilter(face.buckets[bucket].texture, TEXTURE_FILTER_BILINEAR);
+    }
+    face.loaded[bucket] = true;
+    chargeFont(slot);
+    return true;
+}
+
+// Returns the font to draw text of the given size with, its bucket was loaded when the text was drawn
+Font& DesktopEngine::getFont(int id, float fontSize) {
+    return fonts[id].buckets[getFontBucket(fontSize)];
+}
+
+// Charges a font for the textures of its loaded buckets and its TTF data
+void DesktopEngine::chargeFont(int slot) {
+    const FontFace& face = fonts[slot];
+    size_t vram = 0;
+    for (int i = 0; i < NO_FONT_BUCKETS; i++) {
+        if (face.loaded[i]) {
+            const Texture2D& texture = face.buckets[i].texture;
+            vram += GetPixelDataSize(texture.width, texture.height, texture.format);
         }
+    }
+    resources.setLoaded(slot, vram, face.fileData ? face.fileSize : 0);
+}
+
+void DesktopEngine::unloadFont(int slot) {
+    FontFace& face = fonts[slot];
+    for (int i = 0; i < NO_FONT_BUCKETS; i++) {
+        if (face.loaded[i])
+            UnloadFont(face.buckets[i]);
+        face.loaded[i] = false;
+    }
+    UnloadFileData(face.fileData);
+    face.fileData = nullptr;
+    face.fileSize = 0;
+}
 
-        
+void DesktopEngine::unloadResource(int slot) {
+    if (resources.getKind(slot) == RESOURCE_FONT) {
+        unloadFont(slot);
 
-        // Draw the text at the calculated position
-        DrawTextEx(font, text.c_str(), textPosition, (float) fontSize, (float) spacing,
-            { color.r, color.g, color.b, color.a });
+        // Measurements are cached by slot, which a new font may reuse
+        if (!resources.isUsed(slot)) {
+            fonts[slot].filename.clear();
+            textCache.clear();
+        }
+    } else if (!resources.isUsed(slot)) {
+        releaseImage(slot);
     }
 }
 
-void DesktopEngine::startDrawingLowerScreen() {
-    drawing = false;
+void DesktopEngine::renderText(const DrawCommand& command, const char* text) {
+    PROFILE_ZONE("text");
+    float fontSize = command.v[1].x;
+    float spacing = command.v[1].y;
+    if (!resources.isUsed(command.id, RESOURCE_FONT) || !fonts[command.id].loaded[getFontBucket(fontSize)])
+        return;
+
+    const Font& font = getFont(command.id, fontSize);
+    Vector2 textPosition;
+
+    if (command.center) {
+        // Measure the text size, only once for as long as it stays in the cache
+        bool created;
+        int slot = textCache.find(command.id, text, fontSize, spacing, created);
+        if (created)
+            textSizes[slot] = MeasureTextEx(font, text, fontSize, spacing);
+        Vector2 textSize = textSizes[slot];
+
+        // Calculate the position to center the text
+        textPosition = {
+            command.v[0].x - (textSize.x / 2),
+            command.v[0].y - (textSize.y / 2)
+        };
+    } else {
+        textPosition = toVector(command.v[0]);
+    }
+
+    // Draw the text at the calculated position
+    DrawTextEx(font, text, textPosition, fontSize, spacing, toColor(command.color));
 }
-void DesktopEngine::endDrawingLowerScreen() {
-    drawing = true;
-}
\ No newline at end of file
@@ -7,11 +7,33 @@
 
 #include "gameEngine.h"
 #include "shapes.h"
+#include "textCache.h"
+#include "atlas.h"
+#include "fontBuckets.h"
 
 
+#define MAX_LAYER_CACHES 4
+
 using namespace std;
 
-class DesktopEngine : public GameEngine {
+// Offscreen copy of a run of cached layers
+struct LayerCache {
+    int layer;                  // First layer of the run, -1 if the slot is free
+    RenderTexture2D target;     // Holds premultiplied colors
+    uint64_t hash;
+    bool valid;
+};
+
+// A font rasterized on demand at each size bucket it is drawn at
+struct FontFace {
+    string filename;
+    unsigned char* fileData;    // TTF data, read the first time a bucket is rasterized
+    int fileSize;
+    Font buckets[NO_FONT_BUCKETS];
+    bool loaded[NO_FONT_BUCKETS];
+};
+
+class DesktopEngine final : public GameEngine {
 public:
     // Constructor
     DesktopEngine(const char* title);
@@ -21,28 +43,16 @@ public:
 
     // Implement the pure virtual methods from GameEngine
     bool gameIsRunning();
-    void startDrawing();
-    void clearBackground(RGB_Color color);
-    void drawRect(Point p, double width, double height, RGB_Color fill);
-    void drawLine(Point start, Point end, RGB_Color color);
-    void drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill);
-    void drawQuad(Point p1, Point p2, Point p3, Point p4, RGB_Color fill);
-    void endDrawing();
     void freeResources();
-    void startDrawingLowerScreen();
-    void endDrawingLowerScreen();
     void terminateGame();
 
-    int loadImage(const string& filename);
-    void drawImage(int id, Point p, double width, double height);
+    void closeAssetPack();
+    void setIdleRendering(bool idle);
 
+    int loadImage(const string& filename);
     int loadFont(const string& filename);
-    void drawText(int id, const string& text, Point p, bool center,
-        double fontSize, double spacing, RGB_Color color);
 
     void scanInput();
-    const vector<Key> getReleasedKeys();
-    const vector<Key> getHeldKeys();
     Point getTouchHeldPosition();
     Point getTouchReleasedPosition();
     Point getTouchDragged();
@@ -51,14 +61,45 @@ public:
     int getScreenWidth();
     int getScreenHeight();
 
+protected:
+    void renderFrame(const DrawCommandBuffer& commands, bool lowerScreen);
+    void skipFrame(bool lowerScreen);
+    void unloadResource(int slot);
+    bool loadFontSize(int slot, float fontSize);
+
 private:
-    bool drawing = true;
-    vector<Texture2D> textures;
-    vector<Font> fonts;
+    // Images are packed into shared atlas pages the first time they are drawn
+    vector<Texture2D> atlasPages;
+    vector<int> pageImages;     // Live images on each atlas page, the page is freed at 0
+    vector<AtlasRect> imageRects;   // Indexed by slot
+    vector<Image> pendingImages;
+    vector<int> pendingSlots;   // Slot of each pending image
+    vector<int> packTextures;   // Atlas page of each pack entry, -1 until it is uploaded
+    vector<FontFace> fonts;     // Indexed by slot
+    TextCache textCache;
+    Vector2 textSizes[TEXT_CACHE_SLOTS];
+    LayerCache layerCaches[MAX_LAYER_CACHES] = {};
+    vector<CachedSpan> cachedSpans;
+
+    void buildAtlas();
+    int addAtlasPage(Texture2D texture);
+    void releaseImage(int slot);
+    int getPackTexture(int entry);
+    Texture2D loadPackTexture(const AssetEntry& entry);
+    Font loadPackFont(const AssetEntry& entry);
+    Font& getFont(int id, float fontSize);
+    void chargeFont(int slot);
+    void unloadFont(int slot);
+    LayerCache* getLayerCache(int layer);
+    void updateLayerCache(const DrawCommandBuffer& commands, const CachedSpan& span);
+    void renderCommand(const DrawCommandBuffer& commands, const DrawCommand& command);
+    void renderTriangle(const DrawCommand& command);
+    void renderQuad(const DrawCommand& command);
+    void renderBatch(const DrawCommandBuffer& commands, const DrawCommand& command);
+    void renderImage(const DrawCommand& command);
+    void renderText(const DrawCommand& command, const char* text);
 
-    const vector<Key> calcHeldKeys();
-    vector<Key> heldKeys;
-    vector<Key> releasedKeys;
+    uint32_t calcHeldKeys();
     bool wasMousePressed = false;
     bool gameIsTerminated = false;
     Point previousPosition = { -1, -1 };
@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include "drawCommands.h"
+
+using namespace std;
+
+// Texture part of the sort key: untextured primitives first, then images, then fonts
+static uint64_t textureKey(DrawCommandType type, int id) {
+    if (id < 0)
+        return 0;
+    if (type == CMD_TEXT)
+        return 0x8000 | (id & 0x7FFF);
+    return (id + 1) & 0x7FFF;
+}
+
+static bool compareKeys(const DrawCommand& a, const DrawCommand& b) {
+    return a.key < b.key;
+}
+
+DrawCommandBuffer::DrawCommandBuffer() : sequence(0) {
+    commands.reserve(DRAW_COMMAND_RESERVE);
+    text.reserve(DRAW_TEXT_RESERVE);
+    vertices.reserve(DRAW_VERTEX_RESERVE);
+    vertexColors.reserve(DRAW_VERTEX_RESERVE);
+}
+
+DrawCommand& DrawCommandBuffer::add(DrawCommandType type, int layer, int id) {
+    layer = max(0, min(layer, MAX_DRAW_LAYER));
+
+    DrawCommand command = {};
+    command.type = (uint8_t) type;
+    command.id = (int16_t) id;
+
+    // A clear always goes first, whatever layer it was issued on
+    if (type != CMD_CLEAR) {
+        command.key = ((uint64_t) layer << 56) | (textureKey(type, id) << 40) |
+            ((uint64_t) type << 32) | sequence;
+    }
+    sequence++;
+
+    commands.push_back(command);
+    return commands.back();
+}
+
+void DrawCommandBuffer::setText(DrawCommand& command, const char* str, size_t length) {
+    command.textOffset = (uint32_t) text.size();
+    command.textLength = (uint32_t) length;
+    text.insert(text.end(), str, str + length);
+    text.push_back('\0');
+}
+
+const char* DrawCommandBuffer::getText(const DrawCommand& command) const {
+    return &text[command.textOffset];
+}
+
+void DrawCommandBuffer::setVertexCount(DrawCommand& command, size_t count) {
+    command.vertexOffset = (uint32_t) vertices.size();
+    command.vertexCount = (uint32_t) count;
+    vertices.resize(vertices.size() + count);
+    vertexColors.resize(vertexColors.size() + count);
+}
+
+void DrawCommandBuffer::setIndices(DrawCommand& command, const uint16_t* data, size_t count) {
+    command.indexOffset = (uint32_t) indices.size();
+    command.indexCount = (uint32_t) count;
+    indices.insert(indices.end(), data, data + count);
+}
+
+// FNV-1a over a range of bytes
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t DrawCommandBuffer::hash(size_t begin, size_t end) const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = begin; i < end; i++) {
+        const DrawCommand& command = commands[i];
+
+        // Fields are hashed one by one, the sequence number and text offset depend on
+        // the rest of the frame and the struct padding is undefined
+        uint32_t key = (uint32_t) (command.key >> 32);
+        hash = hashBytes(hash, &key, sizeof(key));
+        hash = hashBytes(hash, &command.type, sizeof(command.type));
+        hash = hashBytes(hash, &command.center, sizeof(command.center));
+        hash = hashBytes(hash, &command.id, sizeof(command.id));
+        hash = hashBytes(hash, &command.color, sizeof(command.color));
+        hash = hashBytes(hash, command.v, sizeof(command.v));
+        if (command.type == CMD_TEXT)
+            hash = hashBytes(hash, getText(command), command.textLength + 1);
+        if (command.vertexCount > 0) {
+            hash = hashBytes(hash, getVertices(command), command.vertexCount * sizeof(DrawVertex));
+            hash = hashBytes(hash, getVertexColors(command), command.vertexCount * sizeof(RGB_Color));
+        }
+        if (command.indexCount > 0)
+            hash = hashBytes(hash, getIndices(command), command.indexCount * sizeof(uint16_t));
+    }
+    return hash;
+}
+
+void DrawCommandBuffer::sort() {
+    // Most frames are already drawn back to front, skip the sort for those
+    if (!is_sorted(commands.begin(), commands.end(), compareKeys))
+        std::sort(commands.begin(), commands.end(), compareKeys);
+}
+
+void DrawCommandBuffer::clear() {
+    commands.clear();
+    text.clear();
+    vertices.clear();
+    vertexColors.clear();
+    indices.clear();
+    sequence = 0;
+}
@@ -0,0 +1,92 @@
+#ifndef DRAWCOMMANDS_H
+#define DRAWCOMMANDS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "colors.h"
+
+using namespace std;
+
+#define MAX_DRAW_LAYER 255
+#define DRAW_COMMAND_RESERVE 256
+#define DRAW_TEXT_RESERVE 1024
+#define DRAW_VERTEX_RESERVE 1024
+
+// Primitive types in the order they are submitted within a layer and texture
+enum DrawCommandType { CMD_CLEAR, CMD_RECT, CMD_LINE, CMD_LINES, CMD_TRIANGLE, CMD_QUAD, CMD_QUADS, CMD_MESH,
+    CMD_IMAGE, CMD_TEXT };
+
+struct DrawVertex {
+    float x;
+    float y;
+};
+
+// A single recorded draw call
+//  - CMD_RECT / CMD_IMAGE: v[0] is the top-left corner, v[1] is (width, height)
+//  - CMD_LINE / CMD_TRIANGLE / CMD_QUAD: v[0..3] are the vertices in call order
+//  - CMD_TEXT: v[0] is the position, v[1] is (fontSize, spacing)
+//  - CMD_LINES / CMD_QUADS / CMD_MESH: vertices and their colours are in the vertex arena, two per
+//    line, four per quad around its edge, or indexed by the mesh's triangles
+struct DrawCommand {
+    uint64_t key;           // Layer, texture, primitive type and submission order
+    uint8_t type;           // DrawCommandType
+    uint8_t center;         // Text is centred on its position
+    int16_t id;             // Image or font slot, -1 for untextured primitives
+    RGB_Color color;
+    DrawVertex v[4];
+    uint32_t textOffset;    // Offset of the null-terminated string in the text arena
+    uint32_t textLength;
+    uint32_t vertexOffset;  // First vertex in the vertex arena
+    uint32_t vertexCount;
+    uint32_t indexOffset;   // First index in the index arena
+    uint32_t indexCount;
+};
+
+// Returns the layer a command was issued on
+inline int getDrawLayer(const DrawCommand& command) {
+    return (int) (command.key >> 56);
+}
+
+// Per-frame list of draw commands, sorted by key before submission
+class DrawCommandBuffer {
+public:
+    DrawCommandBuffer();
+
+    // Appends a command and builds its sort key
+    DrawCommand& add(DrawCommandType type, int layer, int id);
+    // Copies text into the arena and attaches it to a command
+    void setText(DrawCommand& command, const char* text, size_t length);
+    // Returns the null-terminated text attached to a command
+    const char* getText(const DrawCommand& command) const;
+    // Reserves room in the vertex arena for a command's vertices and their colours
+    void setVertexCount(DrawCommand& command, size_t count);
+    DrawVertex* getVertices(const DrawCommand& command) { return &vertices[command.vertexOffset]; }
+    const DrawVertex* getVertices(const DrawCommand& command) const { return &vertices[command.vertexOffset]; }
+    RGB_Color* getVertexColors(const DrawCommand& command) { return &vertexColors[command.vertexOffset]; }
+    const RGB_Color* getVertexColors(const DrawCommand& command) const { return &vertexColors[command.vertexOffset]; }
+    // Copies triangle indices into the index arena and attaches them to a command
+    void setIndices(DrawCommand& command, const uint16_t* indices, size_t count);
+    const uint16_t* getIndices(const DrawCommand& command) const { return &indices[command.indexOffset]; }
+    // Hashes what the commands in [begin, end) draw, ignoring where they sit in the buffer
+    uint64_t hash(size_t begin, size_t end) const;
+
+    // Orders commands by layer, texture and primitive type, keeping call order for ties
+    void sort();
+    void clear();
+
+    const DrawCommand* data() const { return commands.data(); }
+    size_t size() const { return commands.size(); }
+    const DrawCommand& operator[](size_t i) const { return commands[i]; }
+
+private:
+    vector<DrawCommand> commands;
+    vector<char> text;
+    vector<DrawVertex> vertices;
+    vector<RGB_Color> vertexColors;
+    vector<uint16_t> indices;
+    uint32_t sequence;
+};
+
+#endif // DRAWCOMMANDS_H
@@ -0,0 +1,22 @@
+#ifndef ENGINETYPE_H
+#define ENGINETYPE_H
+
+// Define which engine to use, USE_HEADLESS_ENGINE runs without a window or GPU. The game
+// loop is compiled for this backend with its engine calls bound statically, as well as
+// for the virtual GameEngine interface
+#ifndef USE_HEADLESS_ENGINE
+#define USE_DESKTOP_ENGINE
+#endif
+
+#ifdef USE_DESKTOP_ENGINE
+    #include "desktopEngine.h"
+    using EngineType = DesktopEngine;
+#elif defined(USE_HEADLESS_ENGINE)
+    #include "headlessEngine.h"
+    using EngineType = HeadlessEngine;
+#else
+    #include "n3dsEngine.h"
+    using EngineType = N3DSEngine;
+#endif
+
+#endif // ENGINETYPE_H
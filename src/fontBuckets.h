@@ -0,0 +1,39 @@
+#ifndef FONTBUCKETS_H
+#define FONTBUCKETS_H
+
+#include <string>
+#include <vector>
+
+// Fonts are rasterized at a few fixed sizes and drawn from the smallest one at least as
+// large as the requested size, so the atlases do not depend on the window size
+#define NO_FONT_BUCKETS 5
+static const int FONT_BUCKET_SIZES[NO_FONT_BUCKETS] = { 16, 32, 64, 128, 256 };
+
+// Characters the game draws, other characters are drawn as '?'
+#define FONT_CODEPOINTS " !'(),-.:?0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+
+using namespace std;
+
+// Returns the bucket to draw text of the given size from
+inline int getFontBucket(double fontSize) {
+    for (int i = 0; i < NO_FONT_BUCKETS - 1; i++) {
+        if (fontSize <= FONT_BUCKET_SIZES[i])
+            return i;
+    }
+    return NO_FONT_BUCKETS - 1;
+}
+
+// Returns the name a bucket of a font is stored by in an asset pack, such as "assets/fonts/Zekton.ttf@32"
+inline string getFontBucketName(const string& font, int bucket) {
+    return font + "@" + to_string(FONT_BUCKET_SIZES[bucket]);
+}
+
+inline vector<int> getFontCodepoints() {
+    const char* characters = FONT_CODEPOINTS;
+    vector<int> codepoints;
+    for (const char* c = characters; *c; c++)
+        codepoints.push_back((unsigned char) *c);
+    return codepoints;
+}
+
+#endif // FONTBUCKETS_H
@@ -3,6 +3,8 @@
 #include <cmath>
 #include <algorithm>
 #include <array>
+#include <cstring>
+#include <atomic>
 
 #include "game.h"
 #include "keys.h"
@@ -10,171 +12,234 @@
 #include "shapes.h"
 #include "gameConstants.h"
 #include "utils.h"
-
-int startGame(GameEngine& gameEngine, GameResources& res) {
-    double currentXOffset = 0;
-    double currentYOffset = 0;
-    int currentYLoop = 0;
-    double speedY = SPEED_Y;
-
-    // Add initial tiles
-    vector<Index2> tiles;
-    Index2 p;
-    for (int i = 0; i < NO_STARTING_TILES; i++) {
-        p = { 0, i };
-        tiles.push_back(p);
+#include "track.h"
+#include "trackGenerator.h"
+#include "textCache.h"
+#include "profiler.h"
+#include "random.h"
+#include "spscQueue.h"
+#include "tripleBuffer.h"
+#include "workerThread.h"
+#include "simulation.h"
+#include "lattice.h"
+#include "engineType.h"
+
+#define NO_LINE_VERTICES (2 * (NO_V_LINES + NO_H_LINES))
+#define NO_TILE_VERTICES (4 * NO_TILES)
+#define LOWER_SCREEN_VERSION 1
+
+// A headless run draws nothing for the simulation to overlap with, so it simulates inline
+#ifdef USE_HEADLESS_ENGINE
+#define SIM_THREADED false
+#else
+#define SIM_THREADED true
+#endif
+
+// Frame of the game published by the simulation thread, everything the renderer reads
+struct GameSnapshot {
+    GameState view;             // State interpolated between the last two steps
+    Index2 tiles[NO_TILES];     // Window of the path being drawn
+    int score;
+    double width;               // Screen size the frame was simulated at
+    double height;
+    bool crashed;
+};
+
+// State shared by the render thread and the simulation thread
+struct Simulation {
+    SpscQueue<InputFrame, SIM_INPUT_QUEUE> inputs;
+    TripleBuffer<GameSnapshot> snapshots;
+    atomic<bool> inputClosed;   // No more input will be sent
+    atomic<bool> finished;      // The simulation has stopped consuming input
+    WorkerEvent inputSent;      // Signalled when input is pushed or closed
+    WorkerEvent inputTaken;     // Signalled when input is popped or the simulation finishes
+
+    // Owned by the simulation thread while it runs
+    GameWorld world;
+    InputRecording* recording;
+
+    Simulation(uint64_t seed) : inputClosed(false), finished(false), world(seed), recording(nullptr) {}
+};
+
+static void publishSnapshot(Simulation& sim, const GameState& view, double width, double height, bool crashed) {
+    GameSnapshot& snapshot = sim.snapshots.writeBuffer();
+    snapshot.view = view;
+    for (int i = 0; i < NO_TILES; i++)
+        snapshot.tiles[i] = sim.world.tiles[i];
+    snapshot.score = getScore(sim.world);
+    snapshot.width = width;
+    snapshot.height = height;
+    snapshot.crashed = crashed;
+    sim.snapshots.publish();
+}
+
+// Simulates one frame of input and publishes the result, returns false once the ship crashed
+static bool simulateRecordedFrame(Simulation& sim, InputFrame frame) {
+    PROFILE_ZONE("simulation frame");
+    if (sim.recording)
+        frame = sim.recording->record(frame);
+
+    bool running = simulateFrame(sim.world, frame);
+
+    // Render between the last two steps
+    GameWorld& world = sim.world;
+    GameState view = interpolateState(world.previousState, world.state, world.accumulator / SIM_STEP, frame.height);
+    publishSnapshot(sim, view, frame.width, frame.height, !running);
+    return running;
+}
+
+// Simulation thread: simulates the input frames in the order they were sampled, so the
+// outcome only depends on the input and not on how the threads are scheduled
+static void runSimulation(void* arg) {
+    Simulation& sim = *(Simulation*) arg;
+    Profiler::setThread(1);
+
+    while (true) {
+        InputFrame frame;
+        if (!sim.inputs.pop(frame)) {
+            // Input sent before the queue was closed is still simulated
+            if (!sim.inputClosed.load(memory_order_acquire)) {
+                sim.inputSent.wait();
+                continue;
+            }
+            if (!sim.inputs.pop(frame))
+                break;
+        }
+        sim.inputTaken.signal();
+        if (!simulateRecordedFrame(sim, frame))
+            break;
     }
 
-    gameEngine.getDeltaTime();
+    sim.finished.store(true, memory_order_release);
+    sim.inputTaken.signal();
+}
 
-    // Main game loop
-    while (gameEngine.gameIsRunning()) {
-        double dt = gameEngine.getDeltaTime();
-        double width = gameEngine.getScreenWidth();
-        double height = gameEngine.getScreenHeight();
+template <typename Engine>
+int startGame(Engine& gameEngine, GameResources& res, uint64_t seed, InputRecording* recording) {
+    // The simulation runs on its own thread, this thread samples input and draws the
+    // newest snapshot, so drawing one frame overlaps with simulating the next
+    Simulation sim(seed);
+    sim.recording = recording;
+    publishSnapshot(sim, sim.world.state, gameEngine.getScreenWidth(), gameEngine.getScreenHeight(), false);
 
-        double perspectivePointX = width * 0.5;
-        double perspectivePointY = height * 0.25;
-
-        Point pPoint = { perspectivePointX, perspectivePointY };
-
-        // Draw shapes
-        gameEngine.startDrawing();
-        gameEngine.clearBackground(COLOR_BLACK);
-        gameEngine.drawImage(res.BG_IMAGE, { 0, 0 }, width, height);
+    TextCounter scoreText("Score: ");
+    VertexLattice lattice;
+    gameEngine.invalidateLowerScreen();
 
-        // Calculate vertical line offset
-        gameEngine.scanInput();
-        
-        vector<Key> keysPressed = gameEngine.getReleasedKeys();
-        if (contains(keysPressed, START_KEY)) {
-            gameEngine.terminateGame();
-            break;
-        }
+    // Only the backgrounds stay still while playing
+    gameEngine.setLayerCached(LAYER_BACKGROUND, true);
+    gameEngine.setLayerCached(LAYER_OVERLAY, false);
+    gameEngine.setLayerCached(LAYER_HUD, false);
 
-        vector<Key> keysHeld = gameEngine.getHeldKeys();
+    if (recording)
+        recording->start(seed, gameEngine.getInputState().held);
 
-        // Moving using keys/buttons
-        if (contains(keysHeld, LEFT_KEY))
-            currentXOffset += width * SPEED_X * dt;
-        if (contains(keysHeld, RIGHT_KEY))
-            currentXOffset -= width * SPEED_X * dt;
+    gameEngine.getDeltaTime();
 
-        // Moving using touchscreen
-        Point touch;
-        if (RELATIVE_SLIDE_MODE) {
-            // Move by sliding touchscreen
-            touch = gameEngine.getTouchDragged();
-            currentXOffset -= SLIDE_SCALE * width * touch.x * dt;
+    // Without a second thread the frames are simulated as they are sampled
+    WorkerThread simThread;
+    bool threaded = SIM_THREADED && simThread.start(runSimulation, &sim);
 
-        }
-        else {
-            // Each point on touchscreen is mapped to currentXOffset
-            touch = gameEngine.getTouchHeldPosition();
-            if (touch.x != -1)
-                currentXOffset = getLineXFromIndex(NO_V_LINES / 2, pPoint, width,
-                    -2 * (V_LINE_SPACING * width) * (((NO_V_LINES / 2) - 0.5) * touch.x + 1));
+    // Main game loop
+    while (gameEngine.gameIsRunning()) {
+        PROFILE_ZONE("frame");
+
+        // Everything the simulation reads from the engine, sent to it in order
+        InputFrame frame;
+        {
+            PROFILE_ZONE("input");
+            gameEngine.scanInput();
+
+            frame.heldKeys = gameEngine.getInputState().held;
+            frame.touch = gameEngine.getTouchHeldPosition();
+            frame.drag = gameEngine.getTouchDragged();
+            frame.deltaTime = gameEngine.getDeltaTime();
+            frame.width = gameEngine.getScreenWidth();
+            frame.height = gameEngine.getScreenHeight();
         }
 
-        // Draw vertical lines
-        int startIndex = -(NO_V_LINES / 2) + 1;
-        int endIndex = startIndex + NO_V_LINES - 1;
-        for (int i = startIndex; i < startIndex + NO_V_LINES; i++) {
-            double x = getLineXFromIndex(i, pPoint, width, currentXOffset);
-            Point start = transformPerspective({ x, 0 }, pPoint, height);
-            Point end = transformPerspective({ x, height }, pPoint, height);
+        if (gameEngine.getInputState().isReleased(START_KEY)) {
+            gameEngine.terminateGame();
+            break;
+        }
 
-            gameEngine.drawLine(start, end, COLOR_WHITE);
+        if (threaded) {
+            // A full queue means the simulation is behind, wait for it rather than drop input
+            while (!sim.inputs.push(frame) && !sim.finished.load(memory_order_acquire))
+                sim.inputTaken.wait();
+            sim.inputSent.signal();
+        } else {
+            simulateRecordedFrame(sim, frame);
         }
 
+        sim.snapshots.update();
+        const GameSnapshot& snapshot = sim.snapshots.read();
+        if (snapshot.crashed)
+            break;
 
-        // Draw horizontal lines
-        double xMin = getLineXFromIndex(startIndex, pPoint, width, currentXOffset);
-        double xMax = getLineXFromIndex(endIndex, pPoint, width, currentXOffset);
+        double width = snapshot.width;
+        double height = snapshot.height;
 
+        double perspectivePointX = width * 0.5;
+        double perspectivePointY = height * 0.25;
 
-        // Calculate horizontal line offset
-        speedY += dt * SPEED_Y_INC_PER_SND;
-        currentYOffset += speedY * height * dt;
+        Point pPoint = { perspectivePointX, perspectivePointY };
 
-        double spacingY = H_LINE_SPACING * height;
-        while (currentYOffset >= spacingY) {
-            currentYOffset -= spacingY;
-            currentYLoop += 1;
-        }
+        double currentXOffset = snapshot.view.xOffset;
+        double currentYOffset = snapshot.view.yOffset;
+        int currentYLoop = snapshot.view.yLoop;
 
-        for (int i = 0; i < NO_H_LINES; i++) {
-            double lineY = getLineYFromIndex(i, height, currentYOffset);
-            Point start = transformPerspective({ xMin, lineY }, pPoint, height);
-            Point end = transformPerspective({ xMax, lineY }, pPoint, height);
+        // Draw shapes
+        gameEngine.startDrawing();
+        gameEngine.clearBackground(COLOR_BLACK);
+        gameEngine.setLayer(LAYER_BACKGROUND);
+        gameEngine.drawImage(res.BG_IMAGE, { 0, 0 }, width, height);
+        gameEngine.setLayer(LAYER_TRACK);
 
-            gameEngine.drawLine(start, end, COLOR_WHITE);
+        // Grid lines and tiles share the lattice's projected vertices
+        {
+            PROFILE_ZONE("projection");
+            lattice.update(pPoint, width, height, currentXOffset, currentYOffset);
         }
 
-        // 1. Generate tiles
-        int lastX = 0, lastY = 0;
-
-        // Clean the tiles that are out of the screen
-        for (int i = (int)tiles.size() - 1; i >= 0; i--) {
-            if (tiles[i].y < currentYLoop) {
-                tiles.erase(tiles.begin() + i);
+        Point vertices[NO_LINE_VERTICES + NO_TILE_VERTICES];
+        int noVertices = 0;
+
+        {
+            PROFILE_ZONE("grid lines");
+            // Vertical lines
+            int startIndex = LATTICE_FIRST_LANE;
+            int endIndex = startIndex + NO_V_LINES - 1;
+            for (int i = startIndex; i <= endIndex; i++) {
+                vertices[noVertices++] = lattice.top(i);
+                vertices[noVertices++] = lattice.bottom(i);
             }
-        }
 
-        if (tiles.size() > 0) {
-            Index2 lastTile = tiles.back();
-            lastX = lastTile.x;
-            lastY = lastTile.y + 1;
+            // Horizontal lines
+            for (int i = 0; i < NO_H_LINES; i++) {
+                vertices[noVertices++] = lattice.at(startIndex, i);
+                vertices[noVertices++] = lattice.at(endIndex, i);
+            }
         }
 
-        // Add new tiles if there is space
-        for (int i = (int)tiles.size(); i <= NO_TILES; i++) {
-            int r = getRandomInt(0, 2);
-            if (lastX <= startIndex)
-                r = 1;
-            if (lastX >= endIndex - 1)
-                r = 2;
-
-            p = { lastX, lastY };
-            tiles.push_back(p);
-
-            if (r == 1) {
-                // Path moves to the right
-                lastX++;
-                p = { lastX, lastY };
-                tiles.push_back(p);
-
-                lastY++;
-                p = { lastX, lastY };
-                tiles.push_back(p);
-
-            }
-            else if (r == 2) {
-                // Path moves to the left
-                lastX--;
-                p = { lastX, lastY };
-                tiles.push_back(p);
-
-                lastY++;
-                p = { lastX, lastY };
-                tiles.push_back(p);
+        {
+            PROFILE_ZONE("tiles");
+            // Tiles, the far edge of a tile is on the row after its near edge
+            for (int i = 0; i < NO_TILES; i++) {
+                Index2 tile = snapshot.tiles[i];
+                int nearRow = tile.y - currentYLoop - 1;
+
+                vertices[noVertices++] = lattice.at(tile.x, nearRow);
+                vertices[noVertices++] = lattice.at(tile.x, nearRow + 1);
+                vertices[noVertices++] = lattice.at(tile.x + 1, nearRow + 1);
+                vertices[noVertices++] = lattice.at(tile.x + 1, nearRow);
             }
-            lastY++;
         }
 
-        // 2. Draw tiles
-        for (int i = 0; i < NO_TILES; i++) {
-            Index2 tile = tiles[i];
-            Point pMin = getTileCoordinates(tile.x, tile.y, pPoint, width, height,
-                currentXOffset, currentYOffset, currentYLoop);
-            Point pMax = getTileCoordinates(tile.x + 1, tile.y + 1, pPoint, width, height,
-                currentXOffset, currentYOffset, currentYLoop);
-
-            Point p1 = transformPerspective({ pMin.x, pMin.y }, pPoint, height);
-            Point p2 = transformPerspective({ pMin.x, pMax.y }, pPoint, height);
-            Point p3 = transformPerspective({ pMax.x, pMax.y }, pPoint, height);
-            Point p4 = transformPerspective({ pMax.x, pMin.y }, pPoint, height);
-            gameEngine.drawQuad(p1, p2, p3, p4, COLOR_WHITE);
+        {
+            PROFILE_ZONE("draw calls");
+            gameEngine.drawLines(vertices, NO_LINE_VERTICES / 2, COLOR_WHITE);
+            gameEngine.drawQuads(vertices + NO_LINE_VERTICES, NO_TILES, COLOR_WHITE);
         }
 
         // Draw ship
@@ -189,29 +254,42 @@ int startGame(GameEngine& gameEngine, GameResources& res) {
 
          gameEngine.drawTriangle(p1, p2, p3, COLOR_BLACK);*/
 
-        // Check if ship is out of bounds
-        Point shipCenter = { centreX, baseY - shipHeight / 2 };
-        if (!checkShipCollision(tiles, shipCenter, pPoint, width, height,
-            currentXOffset, currentYOffset, currentYLoop)) {
-            break;
-        }
-
+        gameEngine.setLayer(LAYER_SHIP);
         gameEngine.drawImage(res.SHIP_IMAGE, { centreX - shipHalfWidth, baseY - shipHeight * 2.5 },
             shipHalfWidth * 2.5, shipHeight * 2.5);
 
         // Display score
-        gameEngine.drawText(res.BTN_FONT, "Score: " + to_string(currentYLoop + 1),
+        gameEngine.setLayer(LAYER_HUD);
+        scoreText.setValue(snapshot.score);
+        gameEngine.drawText(res.BTN_FONT, scoreText.c_str(),
             { 0.025 * width, 0.05 * height }, false, 0.07 * height, 0.001 * width, COLOR_WHITE);
 
         gameEngine.endDrawing();
 
-        gameEngine.startDrawingLowerScreen();
-        gameEngine.clearBackground(COLOR_BLACK);
-        gameEngine.drawImage(res.BTN_BG_IMAGE, { 0, 0 }, width, height);
-        gameEngine.drawText(res.BTN_FONT, "Use the Circle Pad or slide the touchscreen\nto move the Ship",
-        {0.4 * width, 0.2 * height}, true, 0.05 * height, 0.001 * width, COLOR_WHITE);
-        gameEngine.endDrawingLowerScreen();
+        // The lower screen does not change during a game, it is drawn once
+        if (gameEngine.startDrawingLowerScreen(LOWER_SCREEN_VERSION)) {
+            gameEngine.clearBackground(COLOR_BLACK);
+            gameEngine.setLayer(LAYER_BACKGROUND);
+            gameEngine.drawImage(res.BTN_BG_IMAGE, { 0, 0 }, width, height);
+            gameEngine.setLayer(LAYER_HUD);
+            gameEngine.drawText(res.BTN_FONT, "Use the Circle Pad or slide the touchscreen\nto move the Ship",
+            {0.4 * width, 0.2 * height}, true, 0.05 * height, 0.001 * width, COLOR_WHITE);
+            gameEngine.endDrawingLowerScreen();
+        }
     }
 
-    return currentYLoop + 1;
-}
\ No newline at end of file
+    // The simulation finishes the input it was sent before the outcome is read
+    sim.inputClosed.store(true, memory_order_release);
+    sim.inputSent.signal();
+    simThread.join();
+
+    if (recording)
+        recording->finish(getScore(sim.world), hashState(sim.world.state));
+
+    return getScore(sim.world);
+}
+
+// The backends are final, so the calls of the EngineType copy bind statically and inline
+template int startGame(GameEngine& gameEngine, GameResources& res, uint64_t seed, InputRecording* recording);
+template int startGame(EngineType& gameEngine, GameResources& res, uint64_t seed, InputRecording* recording);
+
@@ -1,10 +1,16 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <cstdint>
+
 #include "gameEngine.h"
 #include "resources.h"
+#include "inputRecording.h"
 
-// Starts game
-int startGame(GameEngine& gameEngine, GameResources& res);
+// Starts game, the path is generated from the seed. If a recording is given,
+// the input of every frame is recorded into it along with the outcome.
+// Compiled for GameEngine and for EngineType, the backend of the build
+template <typename Engine>
+int startGame(Engine& gameEngine, GameResources& res, uint64_t seed, InputRecording* recording = nullptr);
 
 #endif // GAME_H
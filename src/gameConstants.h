@@ -11,12 +11,27 @@
 #define SLIDE_SCALE 120
 #define SPEED_X 1.5   // Speed for moving sideways - Percentage of screen width per second
 #define SPEED_Y 0.8 // Speed for moving forward - Percentage of screen height per second
+#ifndef SPEED_Y_INC_PER_SND // Tuning values can be overridden from the compiler command line
 #define SPEED_Y_INC_PER_SND 0.002 // Increase in vertical speed per second
+#endif
+#define SIM_STEP (1.0 / 120) // Fixed simulation step in seconds
+#define SIM_MAX_STEPS 8 // Most simulation steps run for one frame, the rest of a long frame is dropped
+#define SIM_INPUT_QUEUE 4 // Frames of input the simulation thread can fall behind by
+#ifndef NO_TILES
 #define NO_TILES 16
+#endif
 #define NO_STARTING_TILES 10
+#define TRACK_CAPACITY (NO_TILES + 2) // Path is topped up while it has at most NO_TILES, adding up to 2 tiles
 
 #define SHIP_WIDTH 0.07
 #define SHIP_HEIGHT 0.05
 #define SHIP_BASE_Y 0.04
 
+// Draw layers, higher layers are drawn on top
+#define LAYER_BACKGROUND 0
+#define LAYER_OVERLAY 1
+#define LAYER_TRACK 2
+#define LAYER_SHIP 3
+#define LAYER_HUD 4
+
 #endif // GAMECONSTANTS_H
@@ -1,4 +1,8 @@
-#include "GameEngine.h"
+#include <cstring>
+
+#include "gameEngine.h"
+#include "profiler.h"
+#include "random.h"
 
 // Constructor definition
 GameEngine::GameEngine(const char* title) : title(title) {
@@ -9,3 +13,271 @@ GameEngine::GameEngine(const char* title) : title(title) {
 GameEngine::~GameEngine() {
     // Cleanup resources if necessary
 }
+
+bool GameEngine::openAssetPack(const char* filename) {
+    return assetPack.open(filename);
+}
+
+void GameEngine::closeAssetPack() {
+    assetPack.close();
+}
+
+const InputState& GameEngine::getInputState() const {
+    return input;
+}
+
+bool GameEngine::retainResource(int id) {
+    return resources.retain(id);
+}
+
+void GameEngine::releaseResource(int id) {
+    int slot = resources.release(id);
+    if (slot < 0)
+        return;
+    unloadResource(slot);
+
+    // The release count is part of the frame and layer hashes, but the lower screen is only
+    // drawn again when invalidated
+    invalidateLowerScreen();
+}
+
+bool GameEngine::isResourceValid(int id) const {
+    return resources.isValid(id);
+}
+
+void GameEngine::setMemoryBudget(MemoryPool pool, size_t bytes) {
+    resources.setBudget(pool, bytes);
+    trimResources();
+}
+
+size_t GameEngine::getMemoryBudget(MemoryPool pool) const {
+    return resources.getBudget(pool);
+}
+
+size_t GameEngine::getMemoryUsage(MemoryPool pool) const {
+    return resources.getUsage(pool);
+}
+
+void GameEngine::unloadResource(int slot) {
+    // Backends without resource data have nothing to free
+}
+
+bool GameEngine::reloadResource(int slot) {
+    // Backends that load their data lazily when rendering have nothing to do here
+    return true;
+}
+
+bool GameEngine::loadFontSize(int slot, float fontSize) {
+    // Backends whose fonts draw at any size have nothing to do here
+    return true;
+}
+
+void GameEngine::trimResources() {
+    int slot;
+    while ((slot = resources.findEviction()) >= 0) {
+        unloadResource(slot);
+        resources.setUnloaded(slot);
+    }
+}
+
+void GameEngine::startDrawing() {
+    commands.clear();
+    layer = 0;
+    resources.nextFrame();
+    trimResources();
+}
+
+void GameEngine::endDrawing() {
+    flush(false);
+}
+
+void GameEngine::startDrawingLowerScreen() {
+    commands.clear();
+    layer = 0;
+    lowerScreenValid = false;
+}
+
+bool GameEngine::startDrawingLowerScreen(uint32_t version) {
+    // The content is laid out from the screen size, so a resize needs a redraw too
+    int width = getScreenWidth();
+    int height = getScreenHeight();
+    if (lowerScreenValid && lowerScreenVersion == version && lowerScreenWidth == width &&
+        lowerScreenHeight == height)
+        return false;
+
+    startDrawingLowerScreen();
+    lowerScreenVersion = version;
+    lowerScreenWidth = width;
+    lowerScreenHeight = height;
+    lowerScreenValid = true;
+    return true;
+}
+
+void GameEngine::invalidateLowerScreen() {
+    lowerScreenValid = false;
+}
+
+void GameEngine::endDrawingLowerScreen() {
+    flush(true);
+}
+
+void GameEngine::flush(bool lowerScreen) {
+    PROFILE_ZONE("present");
+    commands.sort();
+
+    if (idleRendering) {
+        // The screen size is part of the frame, a resized window is always presented
+        uint64_t size = ((uint64_t) getScreenWidth() << 32) | (uint32_t) getScreenHeight();
+        uint64_t hash = hashSeed(hashSeed(commands.hash(0, commands.size()), size), resources.getReleaseCount());
+
+        int screen = lowerScreen ? 1 : 0;
+        if (presented[screen] && presentedHashes[screen] == hash) {
+            skipFrame(lowerScreen);
+            commands.clear();
+            return;
+        }
+        presentedHashes[screen] = hash;
+        presented[screen] = true;
+    }
+
+    renderFrame(commands, lowerScreen);
+    commands.clear();
+}
+
+void GameEngine::skipFrame(bool lowerScreen) {
+}
+
+void GameEngine::setIdleRendering(bool idle) {
+    idleRendering = idle;
+    presented[0] = false;
+    presented[1] = false;
+}
+
+void GameEngine::setLayer(int layer) {
+    this->layer = layer;
+}
+
+void GameEngine::setLayerCached(int layer, bool cached) {
+    if (layer >= 0 && layer <= MAX_DRAW_LAYER)
+        cachedLayers[layer] = cached;
+}
+
+void GameEngine::findCachedSpans(const DrawCommandBuffer& commands, vector<CachedSpan>& spans) const {
+    spans.clear();
+    size_t i = 0;
+    while (i < commands.size()) {
+        if (commands[i].type == CMD_CLEAR || !cachedLayers[getDrawLayer(commands[i])]) {
+            i++;
+            continue;
+        }
+
+        CachedSpan span;
+        span.begin = i;
+        span.layer = getDrawLayer(commands[i]);
+        while (i < commands.size() && commands[i].type != CMD_CLEAR && cachedLayers[getDrawLayer(commands[i])])
+            i++;
+        span.end = i;
+        span.hash = hashSeed(commands.hash(span.begin, span.end), resources.getReleaseCount());
+        spans.push_back(span);
+    }
+}
+
+void GameEngine::clearBackground(RGB_Color color) {
+    DrawCommand& command = commands.add(CMD_CLEAR, layer, -1);
+    command.color = color;
+}
+
+void GameEngine::drawRect(Point p, double width, double height, RGB_Color fill) {
+    DrawCommand& command = commands.add(CMD_RECT, layer, -1);
+    command.v[0] = { (float) p.x, (float) p.y };
+    command.v[1] = { (float) width, (float) height };
+    command.color = fill;
+}
+
+void GameEngine::drawLine(Point start, Point end, RGB_Color color) {
+    DrawCommand& command = commands.add(CMD_LINE, layer, -1);
+    command.v[0] = { (float) start.x, (float) start.y };
+    command.v[1] = { (float) end.x, (float) end.y };
+    command.color = color;
+}
+
+void GameEngine::drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill) {
+    DrawCommand& command = commands.add(CMD_TRIANGLE, layer, -1);
+    command.v[0] = { (float) p1.x, (float) p1.y };
+    command.v[1] = { (float) p2.x, (float) p2.y };
+    command.v[2] = { (float) p3.x, (float) p3.y };
+    command.color = fill;
+}
+
+void GameEngine::drawQuad(Point p1, Point p2, Point p3, Point p4, RGB_Color fill) {
+    DrawCommand& command = commands.add(CMD_QUAD, layer, -1);
+    command.v[0] = { (float) p1.x, (float) p1.y };
+    command.v[1] = { (float) p2.x, (float) p2.y };
+    command.v[2] = { (float) p3.x, (float) p3.y };
+    command.v[3] = { (float) p4.x, (float) p4.y };
+    command.color = fill;
+}
+
+void GameEngine::drawLines(const Point* points, int noLines, RGB_Color color) {
+    DrawCommand& command = commands.add(CMD_LINES, layer, -1);
+    command.color = color;
+    setBatchVertices(command, points, nullptr, 2 * noLines);
+}
+
+void GameEngine::drawQuads(const Point* points, int noQuads, RGB_Color fill) {
+    DrawCommand& command = commands.add(CMD_QUADS, layer, -1);
+    command.color = fill;
+    setBatchVertices(command, points, nullptr, 4 * noQuads);
+}
+
+void GameEngine::drawMesh(const Point* points, const RGB_Color* colors, int noVertices, const uint16_t* indices,
+    int noIndices) {
+    DrawCommand& command = commands.add(CMD_MESH, layer, -1);
+    command.color = COLOR_WHITE;
+    setBatchVertices(command, points, colors, noVertices);
+    commands.setIndices(command, indices, noIndices);
+}
+
+// Copies the vertices of a batch, a batch without colours uses the colour of the command
+void GameEngine::setBatchVertices(DrawCommand& command, const Point* points, const RGB_Color* colors, int count) {
+    commands.setVertexCount(command, count);
+    DrawVertex* vertices = commands.getVertices(command);
+    RGB_Color* vertexColors = commands.getVertexColors(command);
+    for (int i = 0; i < count; i++) {
+        vertices[i] = { (float) points[i].x, (float) points[i].y };
+        vertexColors[i] = colors ? colors[i] : command.color;
+    }
+}
+
+// Commands refer to resources by slot, a stale handle or a resource that fails to reload is dropped here
+void GameEngine::drawImage(int id, Point p, double width, double height) {
+    int slot = resources.resolve(id, RESOURCE_IMAGE);
+    if (slot < 0 || (!resources.isLoaded(slot) && !reloadResource(slot)))
+        return;
+    resources.touch(slot);
+
+    DrawCommand& command = commands.add(CMD_IMAGE, layer, slot);
+    command.v[0] = { (float) p.x, (float) p.y };
+    command.v[1] = { (float) width, (float) height };
+    command.color = COLOR_WHITE;
+}
+
+void GameEngine::drawText(int id, const string& text, Point p, bool center, double fontSize, double spacing,
+    RGB_Color color) {
+    drawText(id, text.c_str(), p, center, fontSize, spacing, color);
+}
+
+void GameEngine::drawText(int id, const char* text, Point p, bool center, double fontSize, double spacing,
+    RGB_Color color) {
+    int slot = resources.resolve(id, RESOURCE_FONT);
+    if (slot < 0 || (!resources.isLoaded(slot) && !reloadResource(slot)) || !loadFontSize(slot, (float) fontSize))
+        return;
+    resources.touch(slot);
+
+    DrawCommand& command = commands.add(CMD_TEXT, layer, slot);
+    command.v[0] = { (float) p.x, (float) p.y };
+    command.v[1] = { (float) fontSize, (float) spacing };
+    command.center = center;
+    command.color = color;
+    commands.setText(command, text, strlen(text));
+}
@@ -6,6 +6,9 @@
 #include "keys.h"
 #include "colors.h"
 #include "shapes.h"
+#include "drawCommands.h"
+#include "assetPack.h"
+#include "resourceManager.h"
 
 using namespace std;
 
@@ -17,34 +20,77 @@ public:
     // Virtual destructor
     virtual ~GameEngine();
 
+    // Draw calls are buffered during the frame and submitted in one pass when it ends
+    void startDrawing();
+    void endDrawing();
+    void startDrawingLowerScreen();
+    void endDrawingLowerScreen();
+    // Starts drawing the lower screen for a version of its content. Returns false if that version
+    // is already on screen, then nothing is drawn and endDrawingLowerScreen must not be called
+    bool startDrawingLowerScreen(uint32_t version);
+    // Forces the next versioned lower screen to be drawn
+    void invalidateLowerScreen();
+
+    // Sets the layer of the following draw calls, higher layers are drawn on top
+    void setLayer(int layer);
+    // Marks a layer as static. Consecutive cached layers are rendered once into an offscreen
+    // target and composited with one blit, until what they draw or the screen size changes
+    void setLayerCached(int layer, bool cached);
+    // In idle rendering a frame identical to the one on screen is not presented again, and the
+    // engine waits for input instead. Meant for screens that only change in response to input
+    virtual void setIdleRendering(bool idle);
+
+    void clearBackground(RGB_Color color);
+    void drawRect(Point p, double width, double height, RGB_Color fill);
+    void drawLine(Point start, Point end, RGB_Color color);
+    void drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill);
+    void drawQuad(Point p1, Point p2, Point p3,Point p4, RGB_Color fill);
+    // Batched primitives, each submitted as one command. Quads are convex with their four
+    // vertices in order around the edge, either winding is drawn
+    void drawLines(const Point* points, int noLines, RGB_Color color);
+    void drawQuads(const Point* points, int noQuads, RGB_Color fill);
+    // Draws the triangles of an indexed vertex array with a colour per vertex, in either winding
+    void drawMesh(const Point* points, const RGB_Color* colors, int noVertices, const uint16_t* indices,
+        int noIndices);
+    // Draws an image given its id
+    void drawImage(int id, Point p, double width, double height);
+    // Draws text given a string and a font
+    void drawText(int id, const string& text, Point p, bool center, double fontSize, double spacing,
+                  RGB_Color color);
+    void drawText(int id, const char* text, Point p, bool center, double fontSize, double spacing,
+                  RGB_Color color);
+
     // Pure virtual methods to be implemented by derived classes
     virtual bool gameIsRunning() = 0;
-    virtual void startDrawing() = 0;
-    virtual void clearBackground(RGB_Color color) = 0;
-    virtual void drawRect(Point p, double width, double height, RGB_Color fill) = 0;
-    virtual void drawLine(Point start, Point end, RGB_Color color) = 0;
-    virtual void drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill) = 0;
-    virtual void drawQuad(Point p1, Point p2, Point p3,Point p4, RGB_Color fill) = 0;
-    virtual void endDrawing() = 0;
     virtual void freeResources() = 0;
     virtual void terminateGame() = 0;
-    virtual void startDrawingLowerScreen() = 0;
-    virtual void endDrawingLowerScreen() = 0;
+
+    // While a pack is open, assets in it are loaded from it instead of their own files.
+    // Returns false if the pack could not be opened
+    virtual bool openAssetPack(const char* filename);
+    // Closes the pack, assets already loaded from it stay loaded
+    virtual void closeAssetPack();
 
     // Loads an image into the game engine and returns an id for drawing
     virtual int loadImage(const string& filename) = 0;
-    // Draws an image given its id
-    virtual void drawImage(int id, Point p, double width, double height) = 0;
 
     // Loads a font into the game engine and returns an id for drawing
     virtual int loadFont(const string& filename) = 0;
-    // Draws text given a string and a font
-    virtual void drawText(int id, const string& text, Point p, bool center, double fontSize, double spacing,
-                          RGB_Color color) = 0;
+
+    // Image and font ids are generational handles holding a reference each. Once the last
+    // reference is released the resource is freed, and its stale handles draw nothing
+    bool retainResource(int id);
+    void releaseResource(int id);
+    bool isResourceValid(int id) const;
+    // Limits the memory a pool may use, 0 for no limit. Resources that can be reloaded are
+    // evicted least recently drawn first to stay within it, and reloaded when drawn again
+    void setMemoryBudget(MemoryPool pool, size_t bytes);
+    size_t getMemoryBudget(MemoryPool pool) const;
+    size_t getMemoryUsage(MemoryPool pool) const;
 
     virtual void scanInput() = 0;
-    virtual const vector<Key> getReleasedKeys() = 0;
-    virtual const vector<Key> getHeldKeys() = 0;
+    // Returns the keys pressed, held and released as of the last scanInput
+    const InputState& getInputState() const;
     virtual Point getTouchHeldPosition() = 0;
     virtual Point getTouchReleasedPosition() = 0;
     virtual Point getTouchDragged() = 0;
@@ -55,6 +101,50 @@ public:
 
 protected:
     const char* title;
+    InputState input;
+    AssetPack assetPack;
+    ResourceManager resources;
+
+    // A run of sorted commands on cached layers, named by its first layer
+    struct CachedSpan {
+        size_t begin;
+        size_t end;
+        int layer;
+        uint64_t hash;
+    };
+
+    // Submits a frame of sorted draw commands to the screen
+    virtual void renderFrame(const DrawCommandBuffer& commands, bool lowerScreen) = 0;
+    // Finds the runs of commands on cached layers, a clear is never part of one
+    void findCachedSpans(const DrawCommandBuffer& commands, vector<CachedSpan>& spans) const;
+    // Called instead of renderFrame for an unchanged idle frame, until the next input poll
+    virtual void skipFrame(bool lowerScreen);
+    // Frees the data of a slot. Either the resource was evicted, then it stays in use and is
+    // reloaded when next drawn, or it was released and the slot is no longer in use
+    virtual void unloadResource(int slot);
+    // Loads an evicted resource again as it is drawn, while the frame is recorded and before the
+    // GPU frame begins. Returns false if it could not be loaded, then the draw is dropped
+    virtual bool reloadResource(int slot);
+    // Loads what a font needs to draw text at the given size, also while the frame is recorded.
+    // Returns false if it could not be loaded, then the draw is dropped
+    virtual bool loadFontSize(int slot, float fontSize);
+    // Evicts resources until every memory pool fits its budget or nothing more can be evicted
+    void trimResources();
+
+private:
+    DrawCommandBuffer commands;
+    int layer = 0;
+    bool cachedLayers[MAX_DRAW_LAYER + 1] = {};
+    bool idleRendering = false;
+    uint64_t presentedHashes[2];    // Hash of the frame on each screen, valid in idle rendering
+    bool presented[2] = {};
+    uint32_t lowerScreenVersion = 0;
+    int lowerScreenWidth = 0;
+    int lowerScreenHeight = 0;
+    bool lowerScreenValid = false;
+
+    void flush(bool lowerScreen);
+    void setBatchVertices(DrawCommand& command, const Point* points, const RGB_Color* colors, int count);
 };
 
 #endif // GAMEENGINE_H
@@ -0,0 +1,163 @@
+#include "headlessEngine.h"
+
+using namespace std;
+
+HeadlessEngine::HeadlessEngine(const char* title, int width, int height, double deltaTime)
+    : GameEngine(title), width(width), height(height), deltaTime(deltaTime), currentInput() {
+    currentInput.touch = { -1, -1 };
+}
+
+HeadlessEngine::~HeadlessEngine() {
+    // Nothing to release, no window or GPU resources are held
+}
+
+bool HeadlessEngine::gameIsRunning() {
+    if (gameIsTerminated)
+        return false;
+
+    // Without a frame limit the game runs for as long as there is scripted input
+    if (frameLimit < 0)
+        return nextInput < script.size();
+    return frameCount < frameLimit;
+}
+
+void HeadlessEngine::terminateGame() {
+    gameIsTerminated = true;
+}
+
+void HeadlessEngine::renderFrame(const DrawCommandBuffer& commands, bool lowerScreen) {
+    if (recording) {
+        for (size_t i = 0; i < commands.size(); i++) {
+            DrawCall call;
+            call.frame = frameCount;
+            call.lowerScreen = lowerScreen;
+            call.command = commands[i];
+            if (commands[i].type == CMD_TEXT)
+                call.text = commands.getText(commands[i]);
+            if (commands[i].vertexCount > 0) {
+                const DrawVertex* vertices = commands.getVertices(commands[i]);
+                const RGB_Color* colors = commands.getVertexColors(commands[i]);
+                call.vertices.assign(vertices, vertices + commands[i].vertexCount);
+                call.colors.assign(colors, colors + commands[i].vertexCount);
+            }
+            if (commands[i].indexCount > 0) {
+                const uint16_t* indices = commands.getIndices(commands[i]);
+                call.indices.assign(indices, indices + commands[i].indexCount);
+            }
+            drawLog.push_back(call);
+        }
+    }
+
+    // A frame is complete once the top screen has been submitted
+    if (!lowerScreen)
+        frameCount++;
+}
+
+void HeadlessEngine::freeResources() {
+    resourceNames.clear();
+    resources.clear();
+}
+
+// Nothing is loaded, so resources only get a handle and their filename is kept for the log
+int HeadlessEngine::addResource(ResourceKind kind, const string& filename) {
+    int id = resources.create(kind, false);
+    if (id < 0)
+        return -1;
+
+    int slot = resources.resolve(id, kind);
+    resourceNames.resize(resources.getSlotCount());
+    resourceNames[slot] = filename;
+    resources.setLoaded(slot, 0, 0);
+    return id;
+}
+
+int HeadlessEngine::loadImage(const string& filename) {
+    return addResource(RESOURCE_IMAGE, filename);
+}
+
+int HeadlessEngine::loadFont(const string& filename) {
+    return addResource(RESOURCE_FONT, filename);
+}
+
+void HeadlessEngine::unloadResource(int slot) {
+    if (!resources.isUsed(slot))
+        resourceNames[slot].clear();
+}
+
+const string& HeadlessEngine::getResourceName(int slot) {
+    return resourceNames[slot];
+}
+
+void HeadlessEngine::scanInput() {
+    // Remember where the screen was last touched so a release can report it
+    if (currentInput.touch.x != -1)
+        lastTouchPosition = currentInput.touch;
+
+    // Advance to the next scripted frame, no input once the script is exhausted
+    if (nextInput < script.size()) {
+        currentInput = script[nextInput++];
+    } else {
+        currentInput = InputFrame();
+        currentInput.touch = { -1, -1 };
+    }
+
+    input.update(currentInput.heldKeys);
+}
+
+// Returns the (x, y) coordinates as a percentage of touchscreen
+Point HeadlessEngine::getTouchHeldPosition() {
+    return currentInput.touch;
+}
+
+// Returns the (x, y) coordinates as a percentage of tap
+Point HeadlessEngine::getTouchReleasedPosition() {
+    bool isTouching = currentInput.touch.x != -1;
+
+    // If the screen was touched before but is now released, return the last position
+    if (wasTouching && !isTouching) {
+        wasTouching = false;
+        return lastTouchPosition;
+    }
+
+    wasTouching = isTouching;
+    return { -1, -1 };
+}
+
+// Returns the change in (x, y) since last frame in screenwidth/height percent, as scripted
+Point HeadlessEngine::getTouchDragged() {
+    return currentInput.drag;
+}
+
+// Replaces the scripted input frames and restarts from the first
+void HeadlessEngine::setInputScript(const vector<InputFrame>& script) {
+    this->script = script;
+    nextInput = 0;
+}
+
+void HeadlessEngine::setHeldKeys(uint32_t heldKeys) {
+    input.update(heldKeys);
+}
+
+void HeadlessEngine::setFrameLimit(int frames) {
+    frameLimit = frames;
+}
+
+void HeadlessEngine::setDeltaTime(double deltaTime) {
+    this->deltaTime = deltaTime;
+}
+
+void HeadlessEngine::setRecording(bool enabled) {
+    recording = enabled;
+}
+
+const vector<DrawCall>& HeadlessEngine::getDrawLog() {
+    return drawLog;
+}
+
+void HeadlessEngine::clearDrawLog() {
+    drawLog.clear();
+}
+
+int HeadlessEngine::getFrameCount() {
+    return frameCount;
+}
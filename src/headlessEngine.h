@@ -0,0 +1,103 @@
+#ifndef HEADLESSENGINE_H
+#define HEADLESSENGINE_H
+
+#include <string>
+#include <vector>
+
+#include "gameEngine.h"
+#include "colors.h"
+#include "shapes.h"
+#include "inputRecording.h"
+
+#define HEADLESS_WINDOW_WIDTH 900
+#define HEADLESS_WINDOW_HEIGHT 400
+#define HEADLESS_DELTA_TIME (1.0 / 60)
+
+using namespace std;
+
+// A single draw call recorded by the headless engine, in submission order
+struct DrawCall {
+    int frame;
+    bool lowerScreen;
+    DrawCommand command;
+    string text;
+    vector<DrawVertex> vertices;    // Vertices of a batched primitive
+    vector<RGB_Color> colors;
+    vector<uint16_t> indices;
+};
+
+// Engine that needs no window or GPU: draw calls are recorded into a log and
+// input is read from a script of frames, such as the frames of an InputRecording.
+// Frames that leave the time or screen size unset use the engine's own
+class HeadlessEngine final : public GameEngine {
+public:
+    // Constructor
+    HeadlessEngine(const char* title, int width = HEADLESS_WINDOW_WIDTH, int height = HEADLESS_WINDOW_HEIGHT,
+        double deltaTime = HEADLESS_DELTA_TIME);
+
+    // Destructor
+    virtual ~HeadlessEngine();
+
+    // Implement the pure virtual methods from GameEngine
+    bool gameIsRunning();
+    void freeResources();
+    void terminateGame();
+
+    int loadImage(const string& filename);
+    int loadFont(const string& filename);
+
+    void scanInput();
+    Point getTouchHeldPosition();
+    Point getTouchReleasedPosition();
+    Point getTouchDragged();
+
+    // Returns the time of the current frame, or the fixed virtual time step
+    double getDeltaTime() { return currentInput.deltaTime > 0 ? currentInput.deltaTime : deltaTime; }
+    int getScreenWidth() { return currentInput.width > 0 ? currentInput.width : width; }
+    int getScreenHeight() { return currentInput.height > 0 ? currentInput.height : height; }
+
+    // Sets the input consumed one frame per scanInput call
+    void setInputScript(const vector<InputFrame>& script);
+    // Sets the keys held before the first scripted frame
+    void setHeldKeys(uint32_t heldKeys);
+    // Stops the game after a number of frames, -1 runs until the input script is exhausted
+    void setFrameLimit(int frames);
+    // Sets the time reported by getDeltaTime for frames that do not set it
+    void setDeltaTime(double deltaTime);
+    // Enables or disables recording of draw calls
+    void setRecording(bool enabled);
+
+    // Returns the filename of the image or font a draw call's id refers to
+    const string& getResourceName(int slot);
+    const vector<DrawCall>& getDrawLog();
+    void clearDrawLog();
+    int getFrameCount();
+
+protected:
+    void renderFrame(const DrawCommandBuffer& commands, bool lowerScreen);
+    void unloadResource(int slot);
+
+private:
+    int width;
+    int height;
+    double deltaTime;
+
+    vector<string> resourceNames;     // Indexed by slot
+
+    vector<DrawCall> drawLog;
+    bool recording = true;
+    int frameCount = 0;
+    int frameLimit = -1;
+
+    vector<InputFrame> script;
+    size_t nextInput = 0;
+    InputFrame currentInput;
+
+    bool wasTouching = false;
+    bool gameIsTerminated = false;
+    Point lastTouchPosition = { -1, -1 };
+
+    int addResource(ResourceKind kind, const string& filename);
+};
+
+#endif // HEADLESSENGINE_H
@@ -0,0 +1,204 @@
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+
+#include "inputRecording.h"
+
+static const char MAGIC[4] = { 'S', 'G', 'I', 'R' };
+
+static void writeVarint(vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+// Reads a varint at pos, returns false if the data ends first
+static bool readVarint(const vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size())
+            return false;
+        uint8_t byte = in[pos++];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Maps signed values to unsigned so that small magnitudes have short varints
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static void writeU64(vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        out.push_back((uint8_t) (value >> (8 * i)));
+}
+
+static bool readU64(const vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+    if (pos + 8 > in.size())
+        return false;
+    value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t) in[pos++] << (8 * i);
+    return true;
+}
+
+InputRecording::InputRecording() {
+    start(0, 0);
+}
+
+void InputRecording::start(uint64_t seed, uint32_t initialKeys) {
+    this->seed = seed;
+    this->initialKeys = initialKeys;
+    score = 0;
+    stateHash = 0;
+    frameCount = 0;
+    memset(previous, 0, sizeof(previous));
+    data.clear();
+}
+
+void InputRecording::quantize(const InputFrame& frame, int32_t* fields) {
+    fields[FIELD_TIME] = (int32_t) lround(frame.deltaTime * INPUT_TIME_SCALE);
+    fields[FIELD_KEYS] = (int32_t) frame.heldKeys;
+    fields[FIELD_TOUCH_X] = (int32_t) lround((double) frame.touch.x * INPUT_TOUCH_SCALE);
+    fields[FIELD_TOUCH_Y] = (int32_t) lround((double) frame.touch.y * INPUT_TOUCH_SCALE);
+    fields[FIELD_DRAG_X] = (int32_t) lround((double) frame.drag.x * INPUT_TOUCH_SCALE);
+    fields[FIELD_DRAG_Y] = (int32_t) lround((double) frame.drag.y * INPUT_TOUCH_SCALE);
+    fields[FIELD_WIDTH] = frame.width;
+    fields[FIELD_HEIGHT] = frame.height;
+}
+
+InputFrame InputRecording::dequantize(const int32_t* fields) {
+    InputFrame frame;
+    frame.deltaTime = fields[FIELD_TIME] / INPUT_TIME_SCALE;
+    frame.heldKeys = (uint32_t) fields[FIELD_KEYS];
+    frame.touch = { fields[FIELD_TOUCH_X] / INPUT_TOUCH_SCALE, fields[FIELD_TOUCH_Y] / INPUT_TOUCH_SCALE };
+    frame.drag = { fields[FIELD_DRAG_X] / INPUT_TOUCH_SCALE, fields[FIELD_DRAG_Y] / INPUT_TOUCH_SCALE };
+    frame.width = fields[FIELD_WIDTH];
+    frame.height = fields[FIELD_HEIGHT];
+    return frame;
+}
+
+InputFrame InputRecording::record(const InputFrame& frame) {
+    int32_t fields[NO_FIELDS];
+    quantize(frame, fields);
+
+    // A byte with one bit per changed field, followed by the change of each of those fields
+    uint8_t changed = 0;
+    for (int i = 0; i < NO_FIELDS; i++) {
+        if (fields[i] != previous[i])
+            changed |= 1 << i;
+    }
+    data.push_back(changed);
+    for (int i = 0; i < NO_FIELDS; i++) {
+        if (changed & (1 << i))
+            writeVarint(data, zigzag((int64_t) fields[i] - previous[i]));
+        previous[i] = fields[i];
+    }
+
+    frameCount++;
+    return dequantize(fields);
+}
+
+void InputRecording::finish(int score, uint64_t stateHash) {
+    this->score = score;
+    this->stateHash = stateHash;
+}
+
+uint64_t InputRecording::getSeed() const {
+    return seed;
+}
+
+uint32_t InputRecording::getInitialKeys() const {
+    return initialKeys;
+}
+
+int InputRecording::getScore() const {
+    return score;
+}
+
+uint64_t InputRecording::getStateHash() const {
+    return stateHash;
+}
+
+int InputRecording::getFrameCount() const {
+    return frameCount;
+}
+
+size_t InputRecording::getEncodedSize() const {
+    return data.size();
+}
+
+vector<InputFrame> InputRecording::getFrames() const {
+    vector<InputFrame> frames;
+    frames.reserve(frameCount);
+
+    int32_t fields[NO_FIELDS] = {};
+    size_t pos = 0;
+    for (int frame = 0; frame < frameCount && pos < data.size(); frame++) {
+        uint8_t changed = data[pos++];
+        for (int i = 0; i < NO_FIELDS; i++) {
+            uint64_t delta;
+            if ((changed & (1 << i)) && readVarint(data, pos, delta))
+                fields[i] = (int32_t) (fields[i] + unzigzag(delta));
+        }
+        frames.push_back(dequantize(fields));
+    }
+    return frames;
+}
+
+bool InputRecording::save(const char* filename) const {
+    vector<uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+    out.push_back(INPUT_RECORDING_VERSION);
+    writeU64(out, seed);
+    writeU64(out, stateHash);
+    writeVarint(out, initialKeys);
+    writeVarint(out, zigzag(score));
+    writeVarint(out, frameCount);
+    writeVarint(out, data.size());
+    out.insert(out.end(), data.begin(), data.end());
+
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && written;
+}
+
+bool InputRecording::load(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    vector<uint8_t> in;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        in.insert(in.end(), buffer, buffer + read);
+    fclose(file);
+
+    size_t pos = sizeof(MAGIC) + 1;
+    if (in.size() < pos || memcmp(in.data(), MAGIC, sizeof(MAGIC)) != 0
+        || in[sizeof(MAGIC)] != INPUT_RECORDING_VERSION)
+        return false;
+
+    uint64_t newSeed, newHash, keys, newScore, frames, size;
+    if (!readU64(in, pos, newSeed) || !readU64(in, pos, newHash) || !readVarint(in, pos, keys)
+        || !readVarint(in, pos, newScore) || !readVarint(in, pos, frames) || !readVarint(in, pos, size)
+        || size > in.size() - pos)
+        return false;
+
+    start(newSeed, (uint32_t) keys);
+    finish((int) unzigzag(newScore), newHash);
+    frameCount = (int) frames;
+    data.assign(in.begin() + pos, in.begin() + pos + size);
+    return true;
+}
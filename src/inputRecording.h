@@ -0,0 +1,75 @@
+#ifndef INPUTRECORDING_H
+#define INPUTRECORDING_H
+
+#include <cstdint>
+#include <vector>
+
+#include "shapes.h"
+
+#define INPUT_RECORDING_VERSION 1
+#define INPUT_TIME_SCALE 1000000.0   // Frame times are stored in microseconds
+#define INPUT_TOUCH_SCALE 65536.0    // Touch positions and drags are stored in 1/65536 of the screen
+
+#ifdef __3DS__
+#define INPUT_RECORDING_FILE "sdmc:/starglide_input.sgr"
+#else
+#define INPUT_RECORDING_FILE "starglide_input.sgr"
+#endif
+
+using namespace std;
+
+// Everything the game reads from the engine during one frame
+struct InputFrame {
+    uint32_t heldKeys;  // Bitmask of KEY_BIT(key)
+    Point touch;        // Held touch position as a percentage of the screen, {-1, -1} if not touching
+    Point drag;         // Touch movement since the previous frame as a percentage of the screen
+    double deltaTime;   // Seconds, 0 if not set
+    int width;          // Screen size in pixels, 0 if not set
+    int height;
+};
+
+// Input of one game, stored as the changes between consecutive frames so that
+// idle frames cost a single byte. Frames are quantized as they are recorded and
+// the game must use the quantized frame, which makes a replay reproduce it exactly
+class InputRecording {
+public:
+    InputRecording();
+
+    // Starts recording a game played from the given seed with the given keys held
+    void start(uint64_t seed, uint32_t initialKeys);
+    // Quantizes a frame to the stored precision, appends it and returns the stored frame
+    InputFrame record(const InputFrame& frame);
+    // Stores the outcome of the game so a replay can be checked against it
+    void finish(int score, uint64_t stateHash);
+
+    uint64_t getSeed() const;
+    uint32_t getInitialKeys() const;
+    int getScore() const;
+    uint64_t getStateHash() const;
+    int getFrameCount() const;
+    size_t getEncodedSize() const;
+
+    // Decodes the recorded frames
+    vector<InputFrame> getFrames() const;
+
+    bool save(const char* filename) const;
+    bool load(const char* filename);
+
+private:
+    // Quantized fields of a frame, encoded in this order
+    enum Field { FIELD_TIME, FIELD_KEYS, FIELD_TOUCH_X, FIELD_TOUCH_Y, FIELD_DRAG_X, FIELD_DRAG_Y,
+        FIELD_WIDTH, FIELD_HEIGHT, NO_FIELDS };
+
+    uint64_t seed;
+    uint32_t initialKeys;
+    int score;
+    uint64_t stateHash;
+    int frameCount;
+    int32_t previous[NO_FIELDS];
+    vector<uint8_t> data;
+
+    static void quantize(const InputFrame& frame, int32_t* fields);
+    static InputFrame dequantize(const int32_t* fields);
+};
+
+#endif // INPUTRECORDING_H
@@ -1,11 +1,28 @@
 #ifndef KEYS_H
 #define KEYS_H
 
-#include <vector>
+#include <cstdint>
 
 enum Key { START_KEY, SELECT_KEY, UP_KEY, DOWN_KEY, LEFT_KEY, RIGHT_KEY, PRIMARY_KEY };
 
-// Function to check if a key is in a vector of keys
-bool contains(const std::vector<Key>& keys, Key key);
+#define KEY_BIT(key) (1u << (key))
+
+// Keys pressed, held and released since the previous frame, one bit per key
+struct InputState {
+    uint32_t pressed = 0;
+    uint32_t held = 0;
+    uint32_t released = 0;
+
+    // Derives the edges from the keys held this frame
+    void update(uint32_t heldNow) {
+        pressed = heldNow & ~held;
+        released = held & ~heldNow;
+        held = heldNow;
+    }
+
+    bool isPressed(Key key) const { return (pressed & KEY_BIT(key)) != 0; }
+    bool isHeld(Key key) const { return (held & KEY_BIT(key)) != 0; }
+    bool isReleased(Key key) const { return (released & KEY_BIT(key)) != 0; }
+};
 
 #endif // KEYS_H
@@ -0,0 +1,41 @@
+#include "lattice.h"
+#include "utils.h"
+
+VertexLattice::VertexLattice() : valid(false) {}
+
+bool VertexLattice::update(Point pp, double width, double height, double xOffset, double yOffset) {
+    if (valid && pp.x == this->pp.x && pp.y == this->pp.y && width == this->width && height == this->height &&
+        xOffset == this->xOffset && yOffset == this->yOffset)
+        return false;
+
+    // Every vertex of a column shares its x and every vertex of a row shares its y, so the
+    // lines are computed once and the lattice is projected in one batch
+    Scalar xs[NO_V_LINES];
+    for (int i = 0; i < NO_V_LINES; i++) {
+        xs[i] = getLineXFromIndex(LATTICE_FIRST_LANE + i, pp, width, xOffset);
+        tops[i] = { xs[i], 0 };
+        bottoms[i] = { xs[i], height };
+    }
+    // Rows above the top of the screen all collapse onto the perspective point, only the
+    // rows below it need projecting
+    int noVisibleRows = 0;
+    for (int row = 0; row < LATTICE_ROWS; row++) {
+        Scalar y = getLineYFromIndex(LATTICE_FIRST_ROW + row, height, yOffset);
+        if (y > 0)
+            noVisibleRows = row + 1;
+        for (int i = 0; i < NO_V_LINES; i++)
+            vertices[row][i] = y > 0 ? Point { xs[i], y } : pp;
+    }
+
+    transformPerspectiveBatch(&vertices[0][0], &vertices[0][0], noVisibleRows * NO_V_LINES, pp, height);
+    transformPerspectiveBatch(tops, tops, NO_V_LINES, pp, height);
+    transformPerspectiveBatch(bottoms, bottoms, NO_V_LINES, pp, height);
+
+    valid = true;
+    this->pp = pp;
+    this->width = width;
+    this->height = height;
+    this->xOffset = xOffset;
+    this->yOffset = yOffset;
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include "shapes.h"
+#include "gameConstants.h"
+
+#define LATTICE_FIRST_LANE (-(NO_V_LINES / 2) + 1)  // Index of the leftmost vertical line
+#define LATTICE_FIRST_ROW -1                        // Row of the near edge of the nearest tiles
+#define LATTICE_ROWS (NO_TILES + 4)                 // Covers every row the drawn tiles can reach
+
+// Projected vertices of the grid the lines and tiles share. Vertex (lane, row) is where
+// vertical line lane, as in getLineXFromIndex, crosses horizontal line row, as in
+// getLineYFromIndex, so each shared corner is projected once per frame
+class VertexLattice {
+public:
+    VertexLattice();
+
+    // Projects the vertices for a frame, does nothing if the offsets and screen are unchanged.
+    // Returns true if the vertices were recomputed
+    bool update(Point pp, double width, double height, double xOffset, double yOffset);
+
+    // Returns a projected vertex, rows outside the lattice are clamped to its edge
+    const Point& at(int lane, int row) const {
+        row = row < LATTICE_FIRST_ROW ? LATTICE_FIRST_ROW : row;
+        row = row >= LATTICE_FIRST_ROW + LATTICE_ROWS ? LATTICE_FIRST_ROW + LATTICE_ROWS - 1 : row;
+        return vertices[row - LATTICE_FIRST_ROW][lane - LATTICE_FIRST_LANE];
+    }
+
+    // Returns the ends of a vertical line at the top and bottom of the screen
+    const Point& top(int lane) const { return tops[lane - LATTICE_FIRST_LANE]; }
+    const Point& bottom(int lane) const { return bottoms[lane - LATTICE_FIRST_LANE]; }
+
+private:
+    Point vertices[LATTICE_ROWS][NO_V_LINES];
+    Point tops[NO_V_LINES];
+    Point bottoms[NO_V_LINES];
+
+    bool valid;
+    Point pp;
+    double width;
+    double height;
+    double xOffset;
+    double yOffset;
+};
+
+#endif // LATTICE_H
@@ -3,17 +3,9 @@
 #include "game.h"
 #include "menu.h"
 #include "resources.h"
-
-// Define which engine to use
-#define USE_DESKTOP_ENGINE
-
-#ifdef USE_DESKTOP_ENGINE
-    #include "desktopEngine.h"
-    using EngineType = DesktopEngine;
-#else
-    #include "n3dsEngine.h"
-    using EngineType = N3DSEngine;
-#endif
+#include "utils.h"
+#include "profiler.h"
+#include "engineType.h"
 
 using namespace std;
 
@@ -21,13 +13,15 @@ using namespace std;
 int main() {
     EngineType gameEngine("STARGLIDE");
 
-    // Load resouces
+    // Load resouces, from the prebuilt asset pack when there is one
+    gameEngine.openAssetPack(ASSET_PACK_FILE);
     GameResources res;
     res.BG_IMAGE = gameEngine.loadImage("assets/images/bg.png");
     res.SHIP_IMAGE = gameEngine.loadImage("assets/images/ship.png");
     res.BTN_BG_IMAGE = gameEngine.loadImage("gfx/lowerBg.png");
     res.TITLE_FONT = gameEngine.loadFont("assets/fonts/Pirulen.ttf");
     res.BTN_FONT = gameEngine.loadFont("assets/fonts/Zekton.ttf");
+    gameEngine.closeAssetPack();
 
     int back;
 
@@ -37,11 +31,23 @@ int main() {
 
         // Start the game
         while (gameEngine.gameIsRunning() && back != -1) {
-            int score = startGame(gameEngine, res);
+#ifdef RECORD_INPUT
+            // Keep the input of the last game, it can be replayed with bench/replay
+            InputRecording recording;
+            int score = startGame(gameEngine, res, (uint64_t) getCurrentTimeMillis(), &recording);
+            recording.save(INPUT_RECORDING_FILE);
+#else
+            int score = startGame(gameEngine, res, (uint64_t) getCurrentTimeMillis());
+#endif
             back = showMenu(gameEngine, res, "GAME OVER", "RESTART", "Press A or tap the screen to Play Again",
                 "Your score was: " + to_string(score));
         }
     }
+
+#ifdef ENABLE_PROFILER
+    Profiler::exportTrace(PROFILE_TRACE_FILE);
+    Profiler::exportCsv(PROFILE_CSV_FILE);
+#endif
     
     gameEngine.freeResources();
         
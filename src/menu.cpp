@@ -2,6 +2,8 @@
 
 #include "menu.h"
 #include "keys.h"
+#include "gameConstants.h"
+#include "engineType.h"
 
 #define TITLE_SIZE 0.15
 #define TITLE_LEVEL 0.35
@@ -12,10 +14,18 @@
 
 #define BTN_TEXT_SIZE 0.07
 
-int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText, const string& btnText,
+template <typename Engine>
+int showMenu(Engine& gameEngine, GameResources& res, const string& titleText, const string& btnText,
             const string& btnScreenText, const string& message) {
 
     bool touchAlreadyHeld = gameEngine.getTouchHeldPosition().x != -1;
+    int result = 0;
+
+    // Nothing on the menu moves, so every layer is drawn from the cache
+    gameEngine.setLayerCached(LAYER_BACKGROUND, true);
+    gameEngine.setLayerCached(LAYER_OVERLAY, true);
+    gameEngine.setLayerCached(LAYER_HUD, true);
+    gameEngine.setIdleRendering(true);
 
     // Draw starting screen
     while (gameEngine.gameIsRunning()) {
@@ -24,18 +34,19 @@ int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText
 
         // Check for input
         gameEngine.scanInput();
-        vector<Key> keysPressed = gameEngine.getReleasedKeys();
+        const InputState& keys = gameEngine.getInputState();
 
-        if (contains(keysPressed, PRIMARY_KEY))
+        if (keys.isReleased(PRIMARY_KEY))
             break;
 
-        if (contains(keysPressed, START_KEY)) {
+        if (keys.isReleased(START_KEY)) {
             gameEngine.terminateGame();
             break;
         }
 
-        if (contains(keysPressed, SELECT_KEY)) {
-            return -1;
+        if (keys.isReleased(SELECT_KEY)) {
+            result = -1;
+            break;
         }
 
         Point touch = gameEngine.getTouchReleasedPosition();
@@ -48,8 +59,11 @@ int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText
         // Draw menu
         gameEngine.startDrawing();
         gameEngine.clearBackground(COLOR_BLACK);
+        gameEngine.setLayer(LAYER_BACKGROUND);
         gameEngine.drawImage(res.BG_IMAGE, { 0, 0 }, width, height);
+        gameEngine.setLayer(LAYER_OVERLAY);
         gameEngine.drawRect({ 0, 0 }, width, height, BLACK_TINT);
+        gameEngine.setLayer(LAYER_HUD);
         gameEngine.drawText(res.TITLE_FONT, titleText, { 0.5 * width, TITLE_LEVEL * height }, true,
             TITLE_SIZE * height, 0.03 * width, COLOR_WHITE);
 
@@ -61,15 +75,19 @@ int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText
                 BTN_TEXT_SIZE * height, 0.001 * width, COLOR_WHITE);
             offset = 0.15 * height;
         }
+        gameEngine.setLayer(LAYER_OVERLAY);
         gameEngine.drawRect({ (0.5 - BTN_WIDTH / 2) * width, BTN_LEVEL * height + offset }, BTN_WIDTH * width,
             BTN_HEIGHT * height, COLOR_BLUE);
+        gameEngine.setLayer(LAYER_HUD);
         gameEngine.drawText(res.BTN_FONT, btnText, { 0.5 * width, 0.675 * height + offset }, true, BTN_TEXT_SIZE * height,
             0.001 * width, COLOR_WHITE);
         gameEngine.endDrawing();
 
         gameEngine.startDrawingLowerScreen();
         gameEngine.clearBackground(COLOR_BLACK);
+        gameEngine.setLayer(LAYER_BACKGROUND);
         gameEngine.drawImage(res.BTN_BG_IMAGE, { 0, 0 }, width, height);
+        gameEngine.setLayer(LAYER_HUD);
         gameEngine.drawText(res.BTN_FONT, btnScreenText,
         {0.4 * width, 0.2 * height}, true, 0.05 * height, 0.001 * width, COLOR_WHITE);
         if (message == "")
@@ -78,5 +96,12 @@ int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText
         gameEngine.endDrawingLowerScreen();
     }
 
-    return 0;
-}
\ No newline at end of file
+    gameEngine.setIdleRendering(false);
+    return result;
+}
+
+// The backends are final, so the calls of the EngineType copy bind statically and inline
+template int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText, const string& btnText,
+    const string& btnScreenText, const string& message);
+template int showMenu(EngineType& gameEngine, GameResources& res, const string& titleText, const string& btnText,
+    const string& btnScreenText, const string& message);
@@ -8,8 +8,10 @@
 
 using namespace std;
 
-// Displays game menu with a title and a button
-int showMenu(GameEngine& gameEngine, GameResources& res, const string& titleText, const string& btnText,
+// Displays game menu with a title and a button.
+// Compiled for GameEngine and for EngineType, the backend of the build
+template <typename Engine>
+int showMenu(Engine& gameEngine, GameResources& res, const string& titleText, const string& btnText,
               const string& btnScreenText, const string& message);
 
 #endif // MENU_H
@@ -2,12 +2,12 @@
 #include <algorithm> 
 #include <cmath>
 #include <iostream>
+#include <sys/stat.h>
 
 #include "n3DSEngine.h"
 #include "colors.h"
+#include "profiler.h"
 
-#define WINDOW_WIDTH 400
-#define WINDOW_HEIGHT 240
 
 #define TOUCH_WIDTH 320
 #define TOUCH_HEIGHT 240
@@ -34,6 +34,9 @@ string getFilenameWithoutExtension(const string& filepath) {
 }
 
 
+// Images packed into romfs:/gfx/atlas.t3x, in the order they are listed in gfx/atlas.t3s
+static const char* const ATLAS_IMAGES[] = { "bg", "lowerBg", "ship" };
+
 N3DSEngine::N3DSEngine(const char* title) : GameEngine(title) {
     romfsInit();
     cfguInit();
@@ -48,15 +51,24 @@ N3DSEngine::N3DSEngine(const char* title) : GameEngine(title) {
     top = C2D_CreateScreenTarget(GFX_TOP, GFX_LEFT);
     bottom = C2D_CreateScreenTarget(GFX_BOTTOM, GFX_LEFT);
 
+    for (LayerCache& cache : layerCaches)
+        cache.layer = -1;
+
+    // Sheets that were not drawn for a while are freed when textures fill linear memory
+    resources.setBudget(MEMORY_LINEAR, N3DS_LINEAR_BUDGET);
+
     // Prepare timer
     prevTime = svcGetSystemTick();
     ticksPerSecond = SYSCLOCK_ARM11;
-
-    g_staticBuf  = C2D_TextBufNew(4096); // support up to 4096 glyphs in the buffer
 }
 
 N3DSEngine::~N3DSEngine() {
     // Cleanup resources if necessary
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        if (textBufs[i])
+            C2D_TextBufDelete(textBufs[i]);
+    }
+
     // Deinitialise graphics
     C2D_Fini();
     C3D_Fini();
@@ -71,50 +83,199 @@ void N3DSEngine::terminateGame() {
     gameIsTerminated = true;
 }
 
-void N3DSEngine::startDrawing() {
+void N3DSEngine::renderFrame(const DrawCommandBuffer& commands, bool lowerScreen) {
+    C3D_RenderTarget* target = lowerScreen ? bottom : top;
+    if (!lowerScreen)
+        topSkipped = false;
+
     C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-    C2D_TargetClear(top, C2D_Color32(0x68, 0xB0, 0xD8, 0xFF));
-    C2D_SceneBegin(top);
-}
 
-void N3DSEngine::endDrawing() {
+    // Cached runs that changed are rendered to their textures before the screen is bound
+    findCachedSpans(commands, cachedSpans);
+    for (const CachedSpan& span : cachedSpans)
+        updateLayerCache(commands, span, lowerScreen);
+
+    if (!lowerScreen)
+        C2D_TargetClear(top, C2D_Color32(0x68, 0xB0, 0xD8, 0xFF));
+    C2D_SceneBegin(target);
+
+    // Commands arrive sorted back to front, so everything shares one depth
+    size_t nextSpan = 0;
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (nextSpan < cachedSpans.size() && i == cachedSpans[nextSpan].begin) {
+            const CachedSpan& span = cachedSpans[nextSpan++];
+            LayerCache* cache = getLayerCache(span.layer, lowerScreen);
+
+            // Without a free texture the run is drawn directly
+            if (cache && cache->valid) {
+                C2D_Image image = { &cache->tex, &cache->subtex };
+
+                C2D_Flush();
+                C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA,
+                    GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA);
+                C2D_DrawImageAt(image, 0, 0, DRAW_DEPTH);
+                C2D_Flush();
+                C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA,
+                    GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+                i = span.end - 1;
+                continue;
+            }
+        }
+        renderCommand(commands, commands[i], target);
+    }
+
     C3D_FrameEnd(0);
-    C2D_TextBufClear(g_staticBuf);
 }
 
-void N3DSEngine::clearBackground(RGB_Color color) {
-    if (drawingBottom)
-        C2D_TargetClear(bottom, C2D_Color32(color.r, color.g, color.b, color.a));
-    else
-        C2D_TargetClear(top, C2D_Color32(color.r, color.g, color.b, color.a));
-}
+void N3DSEngine::skipFrame(bool lowerScreen) {
+    if (!lowerScreen) {
+        topSkipped = true;
+        return;
+    }
 
-void N3DSEngine::drawRect(Point p, double width, double height, RGB_Color fill) {
-    u32 colorObj = C2D_Color32(fill.r, fill.g, fill.b, fill.a);
-    C2D_DrawRectangle((int) p.x, (int) p.y, 0, (int) width, (int) height, colorObj, colorObj, colorObj, colorObj);
+    // When neither screen was drawn nothing paces the loop, so it sleeps until the next
+    // input poll at the following vertical blank
+    if (topSkipped)
+        gspWaitForVBlank();
 }
 
-void N3DSEngine::drawLine(Point start, Point end, RGB_Color color) {
-    u32 colorObj = C2D_Color32(color.r, color.g, color.b, color.a);
-    C2D_DrawLine((int) start.x, (int) start.y, colorObj, (int) end.x, (int) end.y, colorObj, 1.0f, 1.0f);
+// Returns the texture of the run starting at a layer of a screen
+LayerCache* N3DSEngine::getLayerCache(int layer, bool lowerScreen) {
+    LayerCache* cache = nullptr;
+    for (LayerCache& slot : layerCaches) {
+        if (slot.layer == layer && slot.lowerScreen == lowerScreen)
+            return &slot;
+        if (!cache && slot.layer == -1)
+            cache = &slot;
+    }
+    if (!cache)
+        return nullptr;
+
+    if (!C3D_TexInitVRAM(&cache->tex, LAYER_CACHE_WIDTH, LAYER_CACHE_HEIGHT, GPU_RGBA8))
+        return nullptr;
+    resources.reserve(MEMORY_VRAM, LAYER_CACHE_WIDTH * LAYER_CACHE_HEIGHT * 4);
+    cache->target = C3D_RenderTargetCreateFromTex(&cache->tex, GPU_TEXFACE_2D, 0, -1);
+
+    // Textures are addressed from the bottom, the screen covers the top left corner
+    u16 width = lowerScreen ? TOUCH_WIDTH : N3DS_WINDOW_WIDTH;
+    u16 height = lowerScreen ? TOUCH_HEIGHT : N3DS_WINDOW_HEIGHT;
+    cache->subtex = { width, height, 0.0f, 1.0f, (float) width / LAYER_CACHE_WIDTH,
+        1.0f - (float) height / LAYER_CACHE_HEIGHT };
+
+    cache->lowerScreen = lowerScreen;
+    cache->layer = layer;
+    cache->valid = false;
+    return cache;
 }
 
-void N3DSEngine::drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill) {
-    u32 colorObj = C2D_Color32(fill.r, fill.g, fill.b, fill.a);
-    C2D_DrawTriangle((float) p1.x, (float) p1.y, colorObj,
-                    (float) p2.x, (float) p2.y, colorObj,
-                    (float) p3.x, (float) p3.y, colorObj, 1.0f);
+void N3DSEngine::updateLayerCache(const DrawCommandBuffer& commands, const CachedSpan& span, bool lowerScreen) {
+    LayerCache* cache = getLayerCache(span.layer, lowerScreen);
+    if (!cache || (cache->valid && cache->hash == span.hash))
+        return;
+
+    // Colors are blended as usual but alpha accumulates as coverage, leaving premultiplied
+    // colors that composite exactly like drawing the commands straight to the screen
+    C2D_TargetClear(cache->target, C2D_Color32(0, 0, 0, 0));
+    C2D_SceneBegin(cache->target);
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA,
+        GPU_ONE, GPU_ONE_MINUS_SRC_ALPHA);
+    for (size_t i = span.begin; i < span.end; i++)
+        renderCommand(commands, commands[i], cache->target);
+    C2D_Flush();
+    C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA,
+        GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+
+    cache->hash = span.hash;
+    cache->valid = true;
 }
 
-void N3DSEngine::drawQuad(Point p1, Point p2, Point p3, Point p4, RGB_Color fill) {
-    u32 colorObj = C2D_Color32(fill.r, fill.g, fill.b, fill.a);
-    C2D_DrawTriangle((float) p1.x, (float) p1.y, colorObj,
-                    (float) p2.x, (float) p2.y, colorObj,
-                    (float) p3.x, (float) p3.y, colorObj, 0.9f);
+void N3DSEngine::renderCommand(const DrawCommandBuffer& commands, const DrawCommand& command,
+    C3D_RenderTarget* target) {
+    u32 colorObj = C2D_Color32(command.color.r, command.color.g, command.color.b, command.color.a);
+    const DrawVertex* v = command.v;
+
+    switch (command.type) {
+    case CMD_CLEAR:
+        C2D_TargetClear(target, colorObj);
+        break;
+    case CMD_RECT:
+        C2D_DrawRectangle((int) v[0].x, (int) v[0].y, DRAW_DEPTH, (int) v[1].x, (int) v[1].y,
+            colorObj, colorObj, colorObj, colorObj);
+        break;
+    case CMD_LINE:
+        C2D_DrawLine((int) v[0].x, (int) v[0].y, colorObj, (int) v[1].x, (int) v[1].y, colorObj,
+            1.0f, DRAW_DEPTH);
+        break;
+    case CMD_TRIANGLE:
+        C2D_DrawTriangle(v[0].x, v[0].y, colorObj, v[1].x, v[1].y, colorObj, v[2].x, v[2].y, colorObj,
+            DRAW_DEPTH);
+        break;
+    case CMD_QUAD:
+        C2D_DrawTriangle(v[0].x, v[0].y, colorObj, v[1].x, v[1].y, colorObj, v[2].x, v[2].y, colorObj,
+            DRAW_DEPTH);
+        C2D_DrawTriangle(v[0].x, v[0].y, colorObj, v[2].x, v[2].y, colorObj, v[3].x, v[3].y, colorObj,
+            DRAW_DEPTH);
+        break;
+    case CMD_LINES:
+    case CMD_QUADS:
+    case CMD_MESH:
+        renderBatch(commands, command);
+        break;
+    case CMD_IMAGE:
+        // The image may have been released after it was drawn
+        if (!resources.isUsed(command.id, RESOURCE_IMAGE) || !resources.isLoaded(command.id))
+            break;
+        C2D_DrawImageAt(images[command.id].face, v[0].x, v[0].y, DRAW_DEPTH);
+        break;
+    case CMD_TEXT:
+        renderText(command, commands.getText(command));
+        break;
+    }
+}
 
-    C2D_DrawTriangle((float) p1.x, (float) p1.y, colorObj,
-                    (float) p3.x, (float) p3.y, colorObj,
-                    (float) p4.x, (float) p4.y, colorObj, 0.9f);
+// Submits a batched primitive, consecutive untextured citro2d draws share one GPU batch
+void N3DSEngine::renderBatch(const DrawCommandBuffer& commands, const DrawCommand& command) {
+    if (command.vertexCount == 0)
+        return;
+
+    const DrawVertex* v = commands.getVertices(command);
+    const RGB_Color* colors = commands.getVertexColors(command);
+    u32 c[4];
+
+    switch (command.type) {
+    case CMD_LINES:
+        for (uint32_t i = 0; i + 1 < command.vertexCount; i += 2) {
+            c[0] = C2D_Color32(colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+            c[1] = C2D_Color32(colors[i + 1].r, colors[i + 1].g, colors[i + 1].b, colors[i + 1].a);
+            C2D_DrawLine((int) v[i].x, (int) v[i].y, c[0], (int) v[i + 1].x, (int) v[i + 1].y, c[1],
+                1.0f, DRAW_DEPTH);
+        }
+        break;
+    case CMD_QUADS:
+        for (uint32_t i = 0; i + 3 < command.vertexCount; i += 4) {
+            for (int k = 0; k < 4; k++)
+                c[k] = C2D_Color32(colors[i + k].r, colors[i + k].g, colors[i + k].b, colors[i + k].a);
+            C2D_DrawTriangle(v[i].x, v[i].y, c[0], v[i + 1].x, v[i + 1].y, c[1], v[i + 2].x, v[i + 2].y, c[2],
+                DRAW_DEPTH);
+            C2D_DrawTriangle(v[i].x, v[i].y, c[0], v[i + 2].x, v[i + 2].y, c[2], v[i + 3].x, v[i + 3].y, c[3],
+                DRAW_DEPTH);
+        }
+        break;
+    case CMD_MESH: {
+        const uint16_t* indices = commands.getIndices(command);
+        for (uint32_t i = 0; i + 2 < command.indexCount; i += 3) {
+            for (int k = 0; k < 3; k++) {
+                const RGB_Color& color = colors[indices[i + k]];
+                c[k] = C2D_Color32(color.r, color.g, color.b, color.a);
+            }
+            const DrawVertex& a = v[indices[i]];
+            const DrawVertex& b = v[indices[i + 1]];
+            const DrawVertex& d = v[indices[i + 2]];
+            C2D_DrawTriangle(a.x, a.y, c[0], b.x, b.y, c[1], d.x, d.y, c[2], DRAW_DEPTH);
+        }
+        break;
+    }
+    }
 }
 
 void N3DSEngine::drawPoint(Point p, RGB_Color color) {
@@ -122,57 +283,61 @@ void N3DSEngine::drawPoint(Point p, RGB_Color color) {
 }
 
 void N3DSEngine::freeResources() {
-    // Clear images
+    // Clear images, released and evicted ones have no sheet
     for (Image img : images) {
-        C2D_SpriteSheetFree(img.sheet); 
+        if (img.sheet)
+            C2D_SpriteSheetFree(img.sheet); 
     }
     images.clear();
+
+    if (atlas) {
+        C2D_SpriteSheetFree(atlas);
+        atlas = nullptr;
+    }
+
+    // Clear fonts, along with the text parsed with them
+    for (C2D_Font font : fonts) {
+        if (font)
+            C2D_FontFree(font);
+    }
+    fonts.clear();
+    textCache.clear();
+
+    // Clear cached layers
+    for (LayerCache& cache : layerCaches) {
+        if (cache.layer != -1) {
+            C3D_RenderTargetDelete(cache.target);
+            C3D_TexDelete(&cache.tex);
+        }
+        cache.layer = -1;
+        cache.valid = false;
+    }
+    resources.clear();
 }
 
-const vector<Key> N3DSEngine::calcHeldKeys() {
-    vector<Key> keyVector;
+uint32_t N3DSEngine::calcHeldKeys() {
+    uint32_t keys = 0;
     u32 kHeld = hidKeysHeld();
     if (kHeld & KEY_UP)
-        keyVector.push_back(UP_KEY);
+        keys |= KEY_BIT(UP_KEY);
     if (kHeld & KEY_DOWN)
-        keyVector.push_back(DOWN_KEY);
+        keys |= KEY_BIT(DOWN_KEY);
     if (kHeld & KEY_LEFT)
-        keyVector.push_back(LEFT_KEY);
+        keys |= KEY_BIT(LEFT_KEY);
     if (kHeld & KEY_RIGHT)
-        keyVector.push_back(RIGHT_KEY);
+        keys |= KEY_BIT(RIGHT_KEY);
     if (kHeld & KEY_START)
-        keyVector.push_back(START_KEY);
+        keys |= KEY_BIT(START_KEY);
     if (kHeld & KEY_SELECT)
-        keyVector.push_back(SELECT_KEY);
+        keys |= KEY_BIT(SELECT_KEY);
     if (kHeld & KEY_A)
-        keyVector.push_back(PRIMARY_KEY);
-    return keyVector;
-}
-
-// Function to calculate the difference between two sets of keys
-vector<Key> minusSets(const vector<Key>& a, const vector<Key>& b) {
-    vector<Key> result;
-    for (const Key& key : a) {
-        if (find(b.begin(), b.end(), key) == b.end()) {
-            result.push_back(key);
-        }
-    }
-    return result;
+        keys |= KEY_BIT(PRIMARY_KEY);
+    return keys;
 }
 
 void N3DSEngine::scanInput() {
     hidScanInput();
-    vector<Key> prevHeldKeys = heldKeys;
-    heldKeys = calcHeldKeys();
-    releasedKeys = minusSets(prevHeldKeys, heldKeys);
-}
-
-const vector<Key> N3DSEngine::getReleasedKeys() {
-    return releasedKeys;
-}
-
-const vector<Key> N3DSEngine::getHeldKeys() {
-    return heldKeys;
+    input.update(calcHeldKeys());
 }
 
 // Returns the (x, y) coordinates as a percentage of touchscreen
@@ -231,8 +396,8 @@ Point N3DSEngine::getTouchDragged() {
     Point currentPosition = getTouchHeldPosition();
 
     // Calculate the change in position as percentages
-    double deltaX = currentPosition.x - previousPosition.x;
-    double deltaY = currentPosition.y - previousPosition.y;
+    double deltaX = (double) (currentPosition.x - previousPosition.x);
+    double deltaY = (double) (currentPosition.y - previousPosition.y);
 
     // If the current position is {-1, -1}, return {0, 0} to indicate no movement
     if (currentPosition.x == -1 || previousPosition.x == -1) {
@@ -252,61 +417,144 @@ double N3DSEngine::getDeltaTime() {
     return deltaTime;
 }
 
-int N3DSEngine::getScreenWidth() {
-    return WINDOW_WIDTH;
+// Loads a sheet from the asset pack if it is there, otherwise from romfs:/. Either way the
+// texture is read straight into linear memory, without a copy of the file on the heap
+C2D_SpriteSheet N3DSEngine::loadSheet(const string& path) {
+    int entry = assetPack.isOpen() ? assetPack.find(path.c_str(), ASSET_BLOB) : -1;
+    FILE* file = entry >= 0 ? assetPack.seekData(assetPack.getEntry(entry)) : nullptr;
+    if (file)
+        return C2D_SpriteSheetLoadFromHandle(file);
+    return C2D_SpriteSheetLoad(("romfs:/" + path).c_str());
+}
+
+// Loads the sheet of an image outside the atlas and charges its texture to linear memory,
+// returns false if the sheet could not be loaded
+bool N3DSEngine::loadImageSheet(int slot) {
+    Image& img = images[slot];
+    img.sheet = loadSheet(img.path);
+    if (!img.sheet)
+        return false;
+    img.face = C2D_SpriteSheetGetImage(img.sheet, 0);
+    resources.setLoaded(slot, 0, img.face.tex->size);
+    return true;
 }
-int N3DSEngine::getScreenHeight() {
-    return WINDOW_HEIGHT;
+
+// Only sheets outside the atlas are evicted, they are loaded from romfs as they are drawn
+bool N3DSEngine::reloadResource(int slot) {
+    return resources.getKind(slot) == RESOURCE_IMAGE && loadImageSheet(slot);
 }
 
 int N3DSEngine::loadImage(const string& filename) {
     string imageName = getFilenameWithoutExtension(filename);
-    C2D_SpriteSheet sheet = C2D_SpriteSheetLoad(("romfs:/gfx/" + imageName + ".t3x").c_str());	
-	C2D_Image face = C2D_SpriteSheetGetImage(sheet, 0);
-
-    Image img;
-    img.sheet = sheet;
-    img.face = face;
-    images.push_back(img);
-    return (int) images.size() - 1;
-}
 
-void N3DSEngine::drawImage(int id, Point p, double width, double height) {
-    Image img = images[id];
-    
-    C2D_DrawImageAt(img.face, (float) p.x, (float) p.y, (float) (id % 2));
+    // Images in the atlas share its texture, so drawing them needs no texture switches
+    if (!atlas) {
+        atlas = loadSheet("gfx/atlas.t3x");
+        if (atlas)
+            resources.reserve(MEMORY_LINEAR, C2D_SpriteSheetGetImage(atlas, 0).tex->size);
+    }
+
+    int atlasIndex = -1;
+    for (size_t i = 0; atlas && i < sizeof(ATLAS_IMAGES) / sizeof(ATLAS_IMAGES[0]); i++) {
+        if (imageName == ATLAS_IMAGES[i]) {
+            atlasIndex = (int) i;
+            break;
+        }
+    }
+
+    // Only images with a sheet of their own can be evicted, the atlas stays loaded
+    int id = resources.create(RESOURCE_IMAGE, atlasIndex < 0);
+    if (id < 0)
+        return -1;
+
+    int slot = resources.resolve(id, RESOURCE_IMAGE);
+    images.resize(resources.getSlotCount());
+    Image& img = images[slot];
+    img.sheet = nullptr;
+    img.path.clear();
+    if (atlasIndex >= 0) {
+        img.face = C2D_SpriteSheetGetImage(atlas, atlasIndex);
+        resources.setLoaded(slot, 0, 0);
+    } else {
+        // Images outside the atlas are loaded from a sheet of their own
+        img.path = "gfx/" + imageName + ".t3x";
+        if (!loadImageSheet(slot)) {
+            resources.release(id);
+            return -1;
+        }
+    }
+    return id;
 }
 
+// Parsed text points into the glyph sheets of its font, so fonts are never evicted
 int N3DSEngine::loadFont(const string& filename) {
-    string fontName = getFilenameWithoutExtension(filename);
-    fonts[noFonts] = C2D_FontLoad(("romfs:/gfx/" + fontName + ".bcfnt").c_str());
-
-    return noFonts++;
+    string path = "gfx/" + getFilenameWithoutExtension(filename) + ".bcfnt";
+    int id = resources.create(RESOURCE_FONT, false);
+    if (id < 0)
+        return -1;
+
+    int slot = resources.resolve(id, RESOURCE_FONT);
+    fonts.resize(resources.getSlotCount());
+
+    // The font is read into linear memory either way, so the pack can be closed afterwards
+    int entry = assetPack.isOpen() ? assetPack.find(path.c_str(), ASSET_BLOB) : -1;
+    FILE* file = entry >= 0 ? assetPack.seekData(assetPack.getEntry(entry)) : nullptr;
+    size_t size = 0;
+    if (file) {
+        fonts[slot] = C2D_FontLoadFromHandle(file);
+        size = assetPack.getEntry(entry).size;
+    } else {
+        string romfsPath = "romfs:/" + path;
+        fonts[slot] = C2D_FontLoad(romfsPath.c_str());
+        struct stat info;
+        if (stat(romfsPath.c_str(), &info) == 0)
+            size = info.st_size;
+    }
+    resources.setLoaded(slot, 0, size);
+    return id;
 }
 
-void N3DSEngine::drawText(int id, const string& text, Point p, bool center,
-        double fontSize, double spacing, RGB_Color color) {
-    float size = (float) fontSize / 20.0f;
+void N3DSEngine::unloadResource(int slot) {
+    if (resources.getKind(slot) == RESOURCE_FONT) {
+        // Only released fonts get here, the text parsed with them goes too
+        if (fonts[slot])
+            C2D_FontFree(fonts[slot]);
+        fonts[slot] = nullptr;
+        textCache.clear();
+        return;
+    }
 
-    C2D_TextFontParse(&g_staticText[id], fonts[id], g_staticBuf, text.c_str());
-    C2D_TextOptimize(&g_staticText[id]);
+    // Atlas images have no sheet to free
+    Image& img = images[slot];
+    if (img.sheet)
+        C2D_SpriteSheetFree(img.sheet);
+    img.sheet = nullptr;
+}
+
+void N3DSEngine::renderText(const DrawCommand& command, const char* text) {
+    PROFILE_ZONE("text");
+    if (!resources.isUsed(command.id, RESOURCE_FONT))
+        return;
+
+    float fontSize = command.v[1].x;
+    float size = fontSize / 20.0f;
+
+    // Parsed text is kept per cache slot, so unchanged strings are not parsed again
+    bool created;
+    int slot = textCache.find(command.id, text, 0, 0, created);
+    C2D_Text* prepared = &texts[slot];
+    if (created) {
+        if (textBufs[slot])
+            C2D_TextBufDelete(textBufs[slot]);
+        textBufs[slot] = C2D_TextBufNew(command.textLength + 1);
+        C2D_TextFontParse(prepared, fonts[command.id], textBufs[slot], text);
+        C2D_TextOptimize(prepared);
+    }
 
     u32 flags = C2D_WithColor;
-    if (center)
+    if (command.center)
         flags |= C2D_AlignCenter;
-    
-    C2D_DrawText(&g_staticText[id], flags, (float) p.x, (float) p.y - (fontSize / 1.25),
-        0.0f, size, size, C2D_Color32(color.r, color.g, color.b, color.a));
-}
 
-void N3DSEngine::startDrawingLowerScreen() {
-    C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-    C2D_SceneBegin(bottom);
-    drawingBottom = true;
+    C2D_DrawText(prepared, flags, command.v[0].x, command.v[0].y - (fontSize / 1.25f),
+        DRAW_DEPTH, size, size, C2D_Color32(command.color.r, command.color.g, command.color.b, command.color.a));
 }
-
-void N3DSEngine::endDrawingLowerScreen() {
-    C3D_FrameEnd(0);
-    C2D_TextBufClear(g_staticBuf);
-    drawingBottom = false;
-}
\ No newline at end of file
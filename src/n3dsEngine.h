@@ -10,17 +10,36 @@
 #include "gameEngine.h"
 #include "colors.h"
 #include "shapes.h"
+#include "textCache.h"
 
-#define MAX_NUM_FONTS 32
+#define N3DS_WINDOW_WIDTH 400
+#define N3DS_WINDOW_HEIGHT 240
+#define DRAW_DEPTH 0.5f
+#define MAX_LAYER_CACHES 4
+#define LAYER_CACHE_WIDTH 512   // Smallest power of two sized texture covering either screen
+#define LAYER_CACHE_HEIGHT 256
+#define N3DS_LINEAR_BUDGET (24 * 1024 * 1024)  // Textures and fonts, leaves room for command and text buffers
 
 using namespace std;
 
 struct Image {
-    C2D_SpriteSheet sheet;
+    C2D_SpriteSheet sheet;  // Sheet owned by this image, null if the image is in the atlas or evicted
+    string path;            // Path of the sheet, empty if the image is in the atlas
 	C2D_Image face;
 };
 
-class N3DSEngine : public GameEngine {
+// Offscreen copy of a run of cached layers on one screen
+struct LayerCache {
+    bool lowerScreen;
+    int layer;                  // First layer of the run, -1 if the slot is free
+    C3D_Tex tex;                // Holds premultiplied colors
+    C3D_RenderTarget* target;
+    Tex3DS_SubTexture subtex;
+    uint64_t hash;
+    bool valid;
+};
+
+class N3DSEngine final : public GameEngine {
 public:
     // Constructor
     N3DSEngine(const char* title);
@@ -30,56 +49,59 @@ public:
 
     // Implement the pure virtual methods from GameEngine
     bool gameIsRunning();
-    void startDrawing();
-    void clearBackground(RGB_Color color);
-    void drawRect(Point p, double width, double height, RGB_Color fill);
-    void drawLine(Point start, Point end, RGB_Color color);
-    void drawTriangle(Point p1, Point p2, Point p3, RGB_Color fill);
-    void drawQuad(Point p1, Point p2, Point p3, Point p4, RGB_Color fill);
     void drawPoint(Point p, RGB_Color color);
-    void endDrawing();
     void freeResources();
-    void startDrawingLowerScreen();
-    void endDrawingLowerScreen();
     void terminateGame();
 
     int loadImage(const string& filename);
-    void drawImage(int id, Point p, double width, double height);
-
     int loadFont(const string& filename);
-    void drawText(int id, const string& text, Point p, bool center, double fontSize,
-        double spacing, RGB_Color color);
 
     void scanInput();
-    const vector<Key> getReleasedKeys();
-    const vector<Key> getHeldKeys();
     Point getTouchHeldPosition();
     Point getTouchReleasedPosition();
     Point getTouchDragged();
 
     double getDeltaTime();
-    int getScreenWidth();
-    int getScreenHeight();
+    // The top screen has a fixed size, inlined so the layout folds into constants
+    int getScreenWidth() { return N3DS_WINDOW_WIDTH; }
+    int getScreenHeight() { return N3DS_WINDOW_HEIGHT; }
+
+protected:
+    void renderFrame(const DrawCommandBuffer& commands, bool lowerScreen);
+    void skipFrame(bool lowerScreen);
+    void unloadResource(int slot);
+    bool reloadResource(int slot);
 
 private:
     C3D_RenderTarget* top;
     C3D_RenderTarget* bottom;
     u64 prevTime;
     double ticksPerSecond;
-    vector<Image> images;
+    vector<Image> images;       // Indexed by slot
+    C2D_SpriteSheet atlas = nullptr;
+
+    C2D_SpriteSheet loadSheet(const string& path);
+    bool loadImageSheet(int slot);
+
+    vector<C2D_Font> fonts;     // Indexed by slot
+    TextCache textCache;
+    C2D_TextBuf textBufs[TEXT_CACHE_SLOTS] = {};
+    C2D_Text texts[TEXT_CACHE_SLOTS];
+
+    LayerCache layerCaches[MAX_LAYER_CACHES] = {};
+    vector<CachedSpan> cachedSpans;
 
-    C2D_TextBuf g_staticBuf;
-    C2D_Text g_staticText[MAX_NUM_FONTS];
-    C2D_Font fonts[MAX_NUM_FONTS];
-    int noFonts = 0;
+    LayerCache* getLayerCache(int layer, bool lowerScreen);
+    void updateLayerCache(const DrawCommandBuffer& commands, const CachedSpan& span, bool lowerScreen);
+    void renderCommand(const DrawCommandBuffer& commands, const DrawCommand& command, C3D_RenderTarget* target);
+    void renderBatch(const DrawCommandBuffer& commands, const DrawCommand& command);
+    void renderText(const DrawCommand& command, const char* text);
 
-    const vector<Key> calcHeldKeys();
-    vector<Key> heldKeys;
-    vector<Key> releasedKeys;
+    uint32_t calcHeldKeys();
 
+    bool topSkipped = false;
     bool wasTouching = false;
     bool gameIsTerminated = false;
-    bool drawingBottom = false;
     Point previousPosition = { -1, -1 };
 };
 
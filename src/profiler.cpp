@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "profiler.h"
+
+#ifdef __3DS__
+#include <3ds.h>
+#else
+#include <chrono>
+#endif
+
+using namespace std;
+
+ProfileSample Profiler::samples[PROFILE_SAMPLES];
+atomic<uint32_t> Profiler::sampleCount(0);
+static thread_local int currentThread = 0;
+uint64_t Profiler::origin = Profiler::now();
+
+uint64_t Profiler::now() {
+#ifdef __3DS__
+    return svcGetSystemTick();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double Profiler::ticksPerMicrosecond() {
+#ifdef __3DS__
+    return SYSCLOCK_ARM11 / 1000000.0;
+#else
+    return 1000.0;
+#endif
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    // Each sample claims its own slot, so threads never write the same one
+    uint32_t slot = sampleCount.fetch_add(1, memory_order_relaxed);
+    ProfileSample& sample = samples[slot & (PROFILE_SAMPLES - 1)];
+    sample.name = name;
+    sample.start = start - origin;
+    sample.duration = (uint32_t) (end - start);
+    sample.thread = currentThread;
+}
+
+void Profiler::setThread(int id) {
+    currentThread = id;
+}
+
+void Profiler::clear() {
+    sampleCount = 0;
+    origin = now();
+}
+
+int Profiler::getSampleCount() {
+    return sampleCount < PROFILE_SAMPLES ? (int) sampleCount : PROFILE_SAMPLES;
+}
+
+const ProfileSample& Profiler::getSample(int i) {
+    uint32_t first = sampleCount - getSampleCount();
+    return samples[(first + i) & (PROFILE_SAMPLES - 1)];
+}
+
+bool Profiler::exportTrace(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file)
+        return false;
+
+    double scale = 1.0 / ticksPerMicrosecond();
+    fprintf(file, "{\"traceEvents\":[\n");
+    int count = getSampleCount();
+    for (int i = 0; i < count; i++) {
+        const ProfileSample& sample = getSample(i);
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}%s\n",
+            sample.name, sample.start * scale, sample.duration * scale, sample.thread, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    fclose(file);
+    return true;
+}
+
+// Returns the value at the given percentile of a sorted list
+static double percentile(const vector<uint32_t>& sorted, double p) {
+    size_t i = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+bool Profiler::exportCsv(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file)
+        return false;
+
+    // Group the durations by zone, zones are few so a linear search is enough
+    vector<const char*> names;
+    vector<vector<uint32_t>> durations;
+    int count = getSampleCount();
+    for (int i = 0; i < count; i++) {
+        const ProfileSample& sample = getSample(i);
+        size_t zone = 0;
+        while (zone < names.size() && strcmp(names[zone], sample.name) != 0)
+            zone++;
+        if (zone == names.size()) {
+            names.push_back(sample.name);
+            durations.push_back(vector<uint32_t>());
+        }
+        durations[zone].push_back(sample.duration);
+    }
+
+    double scale = 1.0 / ticksPerMicrosecond();
+    fprintf(file, "zone,count,mean_us,p50_us,p90_us,p99_us,max_us\n");
+    for (size_t zone = 0; zone < names.size(); zone++) {
+        vector<uint32_t>& sorted = durations[zone];
+        sort(sorted.begin(), sorted.end());
+
+        double total = 0;
+        for (size_t i = 0; i < sorted.size(); i++)
+            total += sorted[i];
+
+        fprintf(file, "%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", names[zone], (int) sorted.size(),
+            total / sorted.size() * scale, percentile(sorted, 0.5) * scale, percentile(sorted, 0.9) * scale,
+            percentile(sorted, 0.99) * scale, sorted.back() * scale);
+    }
+
+    fclose(file);
+    return true;
+}
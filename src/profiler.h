@@ -0,0 +1,73 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <atomic>
+
+// Scoped frame profiler. Zones are compiled in only when ENABLE_PROFILER is defined
+// (make PROFILE=1), otherwise PROFILE_ZONE expands to nothing
+#define PROFILE_SAMPLES 16384 // Power of two, the oldest samples are overwritten
+
+#ifdef __3DS__
+#define PROFILE_TRACE_FILE "sdmc:/starglide_trace.json"
+#define PROFILE_CSV_FILE "sdmc:/starglide_zones.csv"
+#else
+#define PROFILE_TRACE_FILE "starglide_trace.json"
+#define PROFILE_CSV_FILE "starglide_zones.csv"
+#endif
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing scope, name must be a string literal
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+struct ProfileSample {
+    const char* name;
+    uint64_t start;         // Ticks since the profiler started
+    uint32_t duration;      // Ticks
+    int thread;             // Id given to the recording thread with setThread
+};
+
+class Profiler {
+public:
+    // Returns the current time in profiler ticks
+    static uint64_t now();
+    static double ticksPerMicrosecond();
+
+    // Records a sample, safe to call from several threads
+    static void record(const char* name, uint64_t start, uint64_t end);
+    // Sets the id the calling thread's samples are tagged with, threads start as 0
+    static void setThread(int id);
+    static void clear();
+
+    static int getSampleCount();
+    // Returns a sample in recording order, the oldest one first
+    static const ProfileSample& getSample(int i);
+
+    // Writes the samples as Chrome trace_event JSON, viewable in chrome://tracing or Perfetto
+    static bool exportTrace(const char* filename);
+    // Writes count, mean, p50, p90, p99 and max in microseconds for each zone
+    static bool exportCsv(const char* filename);
+
+private:
+    static ProfileSample samples[PROFILE_SAMPLES];
+    static std::atomic<uint32_t> sampleCount;
+    static uint64_t origin;
+};
+
+// Records the time between its construction and destruction as a sample
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), start(Profiler::now()) {}
+    ~ProfileZone() { Profiler::record(name, start, Profiler::now()); }
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#endif // PROFILER_H
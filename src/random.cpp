@@ -0,0 +1,42 @@
+#include "random.h"
+
+uint64_t hashSeed(uint64_t seed, uint64_t counter) {
+    uint64_t z = seed + (counter + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint32_t rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+Random::Random(uint64_t seed) {
+    // Expand the seed so similar seeds give unrelated states, the state must not be all zero
+    uint64_t a = hashSeed(seed, 0);
+    uint64_t b = hashSeed(seed, 1);
+    s[0] = (uint32_t) a;
+    s[1] = (uint32_t) (a >> 32);
+    s[2] = (uint32_t) b;
+    s[3] = (uint32_t) (b >> 32) | 1;
+}
+
+uint32_t Random::next() {
+    uint32_t result = rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 11);
+
+    return result;
+}
+
+int Random::nextInt(int a, int b) {
+    // Map 32 random bits onto the range with a multiply instead of a modulo
+    uint32_t range = (uint32_t) (b - a + 1);
+    return a + (int) (((uint64_t) next() * range) >> 32);
+}
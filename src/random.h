@@ -0,0 +1,23 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Hashes a seed and a counter into 64 well-mixed bits (SplitMix64), so any
+// element of a random sequence can be computed without the ones before it
+uint64_t hashSeed(uint64_t seed, uint64_t counter);
+
+// Seeded xoshiro128** generator, fast on the 32-bit 3DS CPU
+class Random {
+public:
+    Random(uint64_t seed);
+
+    uint32_t next();
+    // Returns a random integer between a and b inclusive
+    int nextInt(int a, int b);
+
+private:
+    uint32_t s[4];
+};
+
+#endif // RANDOM_H
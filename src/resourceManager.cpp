@@ -0,0 +1,140 @@
+#include "resourceManager.h"
+
+ResourceManager::ResourceManager() : frame(0), releases(0) {
+    for (int i = 0; i < NO_MEMORY_POOLS; i++) {
+        budgets[i] = 0;
+        usage[i] = 0;
+    }
+}
+
+int ResourceManager::create(ResourceKind kind, bool reloadable) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        if ((int) slots.size() >= MAX_RESOURCES)
+            return -1;
+        slot = (int) slots.size();
+        slots.push_back(Slot());
+        slots[slot].generation = 1;
+    }
+
+    Slot& s = slots[slot];
+    s.refCount = 1;
+    s.kind = (uint8_t) kind;
+    s.reloadable = reloadable;
+    s.loaded = false;
+    for (int i = 0; i < NO_MEMORY_POOLS; i++)
+        s.bytes[i] = 0;
+    s.lastUsed = frame;
+    return (int) (s.generation << RESOURCE_SLOT_BITS) | slot;
+}
+
+// Returns the slot of a live handle of any kind, -1 otherwise
+int ResourceManager::getSlot(int handle) const {
+    if (handle < 0)
+        return -1;
+    int slot = handle & (MAX_RESOURCES - 1);
+    uint32_t generation = (uint32_t) handle >> RESOURCE_SLOT_BITS;
+    if (slot >= (int) slots.size() || slots[slot].refCount == 0 || slots[slot].generation != generation)
+        return -1;
+    return slot;
+}
+
+int ResourceManager::resolve(int handle, ResourceKind kind) const {
+    int slot = getSlot(handle);
+    return slot >= 0 && slots[slot].kind == kind ? slot : -1;
+}
+
+bool ResourceManager::isValid(int handle) const {
+    return getSlot(handle) >= 0;
+}
+
+bool ResourceManager::retain(int handle) {
+    int slot = getSlot(handle);
+    if (slot < 0)
+        return false;
+    slots[slot].refCount++;
+    return true;
+}
+
+int ResourceManager::release(int handle) {
+    int slot = getSlot(handle);
+    if (slot < 0 || --slots[slot].refCount > 0)
+        return -1;
+
+    // Outstanding handles become stale, generation 0 is skipped so no handle is 0
+    Slot& s = slots[slot];
+    setUnloaded(slot);
+    s.generation = (s.generation + 1) & RESOURCE_GENERATION_MASK;
+    if (s.generation == 0)
+        s.generation = 1;
+    freeSlots.push_back(slot);
+    releases++;
+    return slot;
+}
+
+void ResourceManager::setLoaded(int slot, size_t vramBytes, size_t linearBytes) {
+    Slot& s = slots[slot];
+    usage[MEMORY_VRAM] += vramBytes - s.bytes[MEMORY_VRAM];
+    usage[MEMORY_LINEAR] += linearBytes - s.bytes[MEMORY_LINEAR];
+    s.bytes[MEMORY_VRAM] = vramBytes;
+    s.bytes[MEMORY_LINEAR] = linearBytes;
+    s.loaded = true;
+    s.lastUsed = frame;
+}
+
+void ResourceManager::setUnloaded(int slot) {
+    Slot& s = slots[slot];
+    for (int i = 0; i < NO_MEMORY_POOLS; i++) {
+        usage[i] -= s.bytes[i];
+        s.bytes[i] = 0;
+    }
+    s.loaded = false;
+}
+
+void ResourceManager::reserve(MemoryPool pool, size_t bytes) {
+    usage[pool] += bytes;
+}
+
+void ResourceManager::unreserve(MemoryPool pool, size_t bytes) {
+    usage[pool] -= bytes < usage[pool] ? bytes : usage[pool];
+}
+
+int ResourceManager::findEviction() const {
+    bool over[NO_MEMORY_POOLS];
+    bool anyOver = false;
+    for (int i = 0; i < NO_MEMORY_POOLS; i++) {
+        over[i] = budgets[i] > 0 && usage[i] > budgets[i];
+        anyOver = anyOver || over[i];
+    }
+    if (!anyOver)
+        return -1;
+
+    int best = -1;
+    for (int slot = 0; slot < (int) slots.size(); slot++) {
+        const Slot& s = slots[slot];
+        if (s.refCount == 0 || !s.loaded || !s.reloadable || frame - s.lastUsed < RESOURCE_EVICT_AGE)
+            continue;
+
+        // Only resources that would bring an over-budget pool down help
+        bool helps = false;
+        for (int i = 0; i < NO_MEMORY_POOLS; i++)
+            helps = helps || (over[i] && s.bytes[i] > 0);
+        if (helps && (best < 0 || frame - s.lastUsed > frame - slots[best].lastUsed))
+            best = slot;
+    }
+    return best;
+}
+
+void ResourceManager::clear() {
+    for (int slot = 0; slot < (int) slots.size(); slot++) {
+        if (slots[slot].refCount > 0) {
+            slots[slot].refCount = 1;
+            release((int) (slots[slot].generation << RESOURCE_SLOT_BITS) | slot);
+        }
+    }
+    for (int i = 0; i < NO_MEMORY_POOLS; i++)
+        usage[i] = 0;
+}
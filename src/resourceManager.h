@@ -0,0 +1,99 @@
+#ifndef RESOURCEMANAGER_H
+#define RESOURCEMANAGER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+#define RESOURCE_SLOT_BITS 12                           // Up to 4096 live resources
+#define MAX_RESOURCES (1 << RESOURCE_SLOT_BITS)
+#define RESOURCE_GENERATION_MASK (0x7FFFFFFF >> RESOURCE_SLOT_BITS)
+#define RESOURCE_EVICT_AGE 2    // Frames a resource stays loaded after it was drawn, the GPU may still read it
+
+enum ResourceKind { RESOURCE_IMAGE, RESOURCE_FONT };
+
+// Memory a resource is charged to: render targets and GPU textures on desktop are VRAM,
+// textures and fonts on 3DS and data kept on the CPU are linear memory
+enum MemoryPool { MEMORY_VRAM, MEMORY_LINEAR, NO_MEMORY_POOLS };
+
+// Bookkeeping for the images and fonts of an engine, the backends keep their data in arrays
+// indexed by slot. A handle is a slot and the generation of the slot when it was created, so a
+// handle to a released resource resolves to -1 instead of to whatever reuses its slot.
+// Loaded data is charged to memory pools, and while a pool is over its budget the resources
+// that can be reloaded are evicted, least recently drawn first
+class ResourceManager {
+public:
+    ResourceManager();
+
+    // Registers a resource holding one reference and returns its handle, -1 if every slot is taken
+    int create(ResourceKind kind, bool reloadable);
+    // Returns the slot of a handle, -1 if the handle is stale, invalid or of another kind
+    int resolve(int handle, ResourceKind kind) const;
+    // Returns true if the handle refers to a live resource of any kind
+    bool isValid(int handle) const;
+    // Adds a reference, returns false for a stale handle
+    bool retain(int handle);
+    // Drops a reference. Once the last one is gone the slot is freed and returned, so the caller
+    // can free its data, otherwise returns -1
+    int release(int handle);
+
+    // Number of slots freed so far. Draw commands refer to slots, which a new resource may reuse
+    // and be drawn the same way, so hashes of drawn frames mix this in
+    uint32_t getReleaseCount() const { return releases; }
+
+    // Slots ever used, arrays indexed by slot are sized to this
+    int getSlotCount() const { return (int) slots.size(); }
+    bool isUsed(int slot) const { return slots[slot].refCount > 0; }
+    // Returns true if a slot holds a resource of the given kind, a command recorded before its
+    // resource was released may refer to a free or reused slot
+    bool isUsed(int slot, ResourceKind kind) const { return isUsed(slot) && getKind(slot) == kind; }
+    ResourceKind getKind(int slot) const { return (ResourceKind) slots[slot].kind; }
+
+    // Charges a slot for its loaded data, replacing its previous charge
+    void setLoaded(int slot, size_t vramBytes, size_t linearBytes);
+    // Clears the charge of a slot whose data was freed, it is reloaded when next drawn
+    void setUnloaded(int slot);
+    bool isLoaded(int slot) const { return slots[slot].loaded; }
+    // Marks a resource as drawn in the current frame
+    void touch(int slot) { slots[slot].lastUsed = frame; }
+    void nextFrame() { frame++; }
+
+    // Charges memory that belongs to no single resource, such as atlas pages and render targets
+    void reserve(MemoryPool pool, size_t bytes);
+    void unreserve(MemoryPool pool, size_t bytes);
+
+    // A budget of 0 is unlimited
+    void setBudget(MemoryPool pool, size_t bytes) { budgets[pool] = bytes; }
+    size_t getBudget(MemoryPool pool) const { return budgets[pool]; }
+    size_t getUsage(MemoryPool pool) const { return usage[pool]; }
+    // Returns the next slot to evict, the least recently drawn reloadable resource charged to a
+    // pool over its budget. Returns -1 once every pool fits or nothing more can be evicted
+    int findEviction() const;
+
+    // Forgets every resource, handles given out before stay stale
+    void clear();
+
+private:
+    struct Slot {
+        uint32_t generation;
+        int refCount;               // 0 if the slot is free
+        uint8_t kind;
+        bool reloadable;
+        bool loaded;
+        size_t bytes[NO_MEMORY_POOLS];
+        uint32_t lastUsed;          // Frame the resource was last drawn or loaded in
+    };
+
+    vector<Slot> slots;
+    vector<int> freeSlots;
+    size_t budgets[NO_MEMORY_POOLS];
+    size_t usage[NO_MEMORY_POOLS];
+    uint32_t frame;
+    uint32_t releases;
+
+    int getSlot(int handle) const;
+};
+
+#endif // RESOURCEMANAGER_H
@@ -0,0 +1,48 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+// Fixed-capacity circular buffer with O(1) push_back and pop_front.
+// Every element is stored twice, Capacity slots apart, so the live elements
+// are always contiguous in memory starting at data()
+template <typename T, int Capacity>
+class RingBuffer {
+public:
+    RingBuffer() : head(0), count(0) {}
+
+    // Appends an element, the buffer must not be full
+    void push_back(const T& value) {
+        int tail = (head + count) % Capacity;
+        items[tail] = value;
+        items[tail + Capacity] = value;
+        count++;
+    }
+
+    // Removes the oldest element, the buffer must not be empty
+    void pop_front() {
+        head = (head + 1) % Capacity;
+        count--;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Read only, a write through an element would only reach one of its two copies
+    const T& operator[](int i) const { return items[head + i]; }
+    const T& front() const { return items[head]; }
+    const T& back() const { return items[head + count - 1]; }
+    const T* data() const { return &items[head]; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+    static int capacity() { return Capacity; }
+
+private:
+    T items[2 * Capacity];
+    int head;
+    int count;
+};
+
+#endif // RINGBUFFER_H
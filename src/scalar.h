@@ -0,0 +1,73 @@
+#ifndef SCALAR_H
+#define SCALAR_H
+
+#include <cstdint>
+#include <cmath>
+
+// Signed 16.16 fixed-point number. Covers +-32768 with a resolution of 1/65536, which is
+// plenty for screen space geometry and needs only integer instructions
+class Fixed16 {
+public:
+    static const int FRACTION_BITS = 16;
+    static const int32_t ONE = 1 << FRACTION_BITS;
+
+    Fixed16() : raw(0) {}
+    Fixed16(int v) : raw(v * ONE) {}
+    Fixed16(float v) : raw(round(v * (float) ONE)) {}
+    Fixed16(double v) : raw(round(v * ONE)) {}
+
+    static Fixed16 fromRaw(int32_t raw) {
+        Fixed16 f;
+        f.raw = raw;
+        return f;
+    }
+    int32_t getRaw() const { return raw; }
+
+    explicit operator double() const { return raw * (1.0 / ONE); }
+    explicit operator float() const { return raw * (1.0f / ONE); }
+    // Truncates towards zero like a float to int cast
+    explicit operator int() const { return raw >= 0 ? raw >> FRACTION_BITS : -(-raw >> FRACTION_BITS); }
+
+    Fixed16 operator-() const { return fromRaw(-raw); }
+    Fixed16& operator+=(Fixed16 o) { raw += o.raw; return *this; }
+    Fixed16& operator-=(Fixed16 o) { raw -= o.raw; return *this; }
+    Fixed16& operator*=(Fixed16 o) { raw = (int32_t) (((int64_t) raw * o.raw) >> FRACTION_BITS); return *this; }
+    Fixed16& operator/=(Fixed16 o) { raw = (int32_t) ((int64_t) raw * ONE / o.raw); return *this; }
+
+    friend Fixed16 operator+(Fixed16 a, Fixed16 b) { return a += b; }
+    friend Fixed16 operator-(Fixed16 a, Fixed16 b) { return a -= b; }
+    friend Fixed16 operator*(Fixed16 a, Fixed16 b) { return a *= b; }
+    friend Fixed16 operator/(Fixed16 a, Fixed16 b) { return a /= b; }
+
+    friend bool operator==(Fixed16 a, Fixed16 b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed16 a, Fixed16 b) { return a.raw != b.raw; }
+    friend bool operator<(Fixed16 a, Fixed16 b) { return a.raw < b.raw; }
+    friend bool operator<=(Fixed16 a, Fixed16 b) { return a.raw <= b.raw; }
+    friend bool operator>(Fixed16 a, Fixed16 b) { return a.raw > b.raw; }
+    friend bool operator>=(Fixed16 a, Fixed16 b) { return a.raw >= b.raw; }
+
+    // Rounds down to a whole number
+    friend Fixed16 floor(Fixed16 f) { return fromRaw(f.raw & ~(ONE - 1)); }
+
+private:
+    template <typename F>
+    static int32_t round(F v) { return (int32_t) (v >= 0 ? v + (F) 0.5 : v - (F) 0.5); }
+
+    int32_t raw;
+};
+
+// Scalar type of Point and the geometry helpers, chosen at build time: SCALAR_FLOAT selects
+// float, SCALAR_FIXED selects 16.16 fixed point and the default is double. The game state
+// stays in double, only positions on the screen use the scalar type
+#if defined(SCALAR_FIXED)
+typedef Fixed16 Scalar;
+#define SCALAR_NAME "fixed"
+#elif defined(SCALAR_FLOAT)
+typedef float Scalar;
+#define SCALAR_NAME "float"
+#else
+typedef double Scalar;
+#define SCALAR_NAME "double"
+#endif
+
+#endif // SCALAR_H
@@ -1,12 +1,23 @@
 #ifndef SHAPES_H
 #define SHAPES_H
 
+#include "scalar.h"
 
-struct Point {
-    double x;
-    double y;
+
+template <typename T>
+struct PointT {
+    T x;
+    T y;
+
+    PointT() {}
+    // Coordinates are converted to the scalar type, so points can be built from the
+    // double game state whichever scalar type is selected
+    template <typename X, typename Y>
+    PointT(X x, Y y) : x(T(x)), y(T(y)) {}
 };
 
+typedef PointT<Scalar> Point;
+
 struct Index2 {
     int x;
     int y;
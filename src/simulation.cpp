@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstring>
+
+#include "simulation.h"
+#include "keys.h"
+#include "utils.h"
+#include "profiler.h"
+#include "random.h"
+
+GameWorld::GameWorld(uint64_t seed) : accumulator(0), pendingSlide(0), generator(seed), nextRow(0), crash(CRASH_NONE),
+    crashTile({ 0, 0 }) {
+    state = { 0, 0, 0, SPEED_Y };
+    previousState = state;
+
+    // The path is generated row by row from the seed
+    while (tiles.size() <= NO_TILES)
+        generator.addRow(tiles, nextRow++);
+}
+
+// Returns the ship centre on screen, the ship never moves, the track does
+static Point getShipCenter(double width, double height) {
+    double baseY = height - SHIP_BASE_Y * height;
+    double shipHeight = SHIP_HEIGHT * height;
+    return { width / 2, baseY - shipHeight / 2 };
+}
+
+// Works out which side of the path the ship left it on, and if that was on a turn: a row where
+// the path changes lane, or the row after it where a missed turn ends. Rows are taken from the
+// generator, the row before may already have been removed from the track
+static CrashCause classifyCrash(TrackGenerator& generator, Index2 tile) {
+    TrackRow previous = generator.getRow(tile.y - 1);
+    TrackRow row = generator.getRow(tile.y);
+    bool turn = previous.turn != 0 || row.turn != 0;
+
+    int minLane = min(row.lane, row.lane + row.turn);
+    if (tile.x < minLane)
+        return turn ? CRASH_TURN_LEFT : CRASH_OFF_LEFT;
+    return turn ? CRASH_TURN_RIGHT : CRASH_OFF_RIGHT;
+}
+
+bool stepGame(GameWorld& world, StepInput& input, double width, double height) {
+    GameState& state = world.state;
+    double dt = SIM_STEP;
+    Point pPoint = { width * 0.5, height * 0.25 };
+
+    // Moving using keys/buttons
+    if (input.left)
+        state.xOffset += width * SPEED_X * dt;
+    if (input.right)
+        state.xOffset -= width * SPEED_X * dt;
+
+    // Moving using touchscreen
+    if (RELATIVE_SLIDE_MODE) {
+        // The slide is applied once, by the first step that runs after it was sampled
+        state.xOffset -= SLIDE_SCALE * width * input.slide;
+        input.slide = 0;
+    }
+    else if (input.touch.x != -1) {
+        // Each point on touchscreen is mapped to xOffset
+        state.xOffset = (double) getLineXFromIndex(NO_V_LINES / 2, pPoint, width,
+            -2 * (V_LINE_SPACING * width) * (((NO_V_LINES / 2) - 0.5) * (double) input.touch.x + 1));
+    }
+
+    // Calculate horizontal line offset
+    state.speedY += dt * SPEED_Y_INC_PER_SND;
+    state.yOffset += state.speedY * height * dt;
+
+    double spacingY = H_LINE_SPACING * height;
+    while (state.yOffset >= spacingY) {
+        state.yOffset -= spacingY;
+        state.yLoop += 1;
+    }
+
+    // Clean the tiles that are out of the screen and add new tiles if there is space
+    {
+        PROFILE_ZONE("tile generation");
+        world.tiles.removeBefore(state.yLoop);
+        while (world.tiles.size() <= NO_TILES)
+            world.generator.addRow(world.tiles, world.nextRow++);
+    }
+
+    // Check if ship is out of bounds
+    PROFILE_ZONE("collision");
+    Point shipCenter = getShipCenter(width, height);
+    if (checkShipCollision(world.tiles, shipCenter, pPoint, width, height,
+        state.xOffset, state.yOffset, state.yLoop))
+        return true;
+
+    world.crashTile = getTileIndex(shipCenter, pPoint, width, height, state.xOffset, state.yOffset, state.yLoop);
+    world.crash = classifyCrash(world.generator, world.crashTile);
+    return false;
+}
+
+bool simulateFrame(GameWorld& world, const InputFrame& frame) {
+    double dt = frame.deltaTime;
+
+    StepInput stepInput;
+    stepInput.left = (frame.heldKeys & KEY_BIT(LEFT_KEY)) != 0;
+    stepInput.right = (frame.heldKeys & KEY_BIT(RIGHT_KEY)) != 0;
+    stepInput.slide = world.pendingSlide + (RELATIVE_SLIDE_MODE ? (double) frame.drag.x * dt : 0);
+    stepInput.touch = RELATIVE_SLIDE_MODE ? Point { -1, -1 } : frame.touch;
+
+    world.accumulator += dt;
+    int steps = 0;
+    while (world.accumulator >= SIM_STEP && steps < SIM_MAX_STEPS) {
+        PROFILE_ZONE("simulation step");
+        world.previousState = world.state;
+        if (!stepGame(world, stepInput, frame.width, frame.height))
+            return false;
+        world.accumulator -= SIM_STEP;
+        steps++;
+    }
+    if (steps == SIM_MAX_STEPS && world.accumulator >= SIM_STEP)
+        world.accumulator = 0;
+
+    // A frame shorter than a step keeps its slide for the next frame that steps
+    world.pendingSlide = stepInput.slide;
+    return true;
+}
+
+GameState interpolateState(const GameState& previous, const GameState& current, double alpha, double height) {
+    double spacingY = H_LINE_SPACING * height;
+    double previousY = previous.yLoop * spacingY + previous.yOffset;
+    double currentY = current.yLoop * spacingY + current.yOffset;
+    double y = previousY + (currentY - previousY) * alpha;
+
+    GameState state = current;
+    state.xOffset = previous.xOffset + (current.xOffset - previous.xOffset) * alpha;
+    state.yLoop = (int) floor(y / spacingY);
+    state.yOffset = y - state.yLoop * spacingY;
+    return state;
+}
+
+uint64_t hashState(const GameState& state) {
+    double values[] = { state.xOffset, state.yOffset, state.speedY };
+    uint64_t hash = hashSeed(0, (uint64_t) state.yLoop);
+    for (int i = 0; i < 3; i++) {
+        uint64_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        hash = hashSeed(hash, bits);
+    }
+    return hash;
+}
+
+PointT<double> getShipTilePosition(const GameState& state, double width, double height) {
+    Point pPoint = { width * 0.5, height * 0.25 };
+    Point t = getTilePosition(getShipCenter(width, height), pPoint, width, height, state.xOffset, state.yOffset);
+    // The row is made absolute in double, it soon outgrows the range of fixed point
+    return { (double) t.x, (double) t.y + state.yLoop };
+}
+
+int getScore(const GameWorld& world) {
+    return world.state.yLoop + 1;
+}
+
+const char* getCrashCauseName(CrashCause cause) {
+    switch (cause) {
+    case CRASH_OFF_LEFT:
+        return "off left";
+    case CRASH_OFF_RIGHT:
+        return "off right";
+    case CRASH_TURN_LEFT:
+        return "turn left";
+    case CRASH_TURN_RIGHT:
+        return "turn right";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+
+#include "shapes.h"
+#include "gameConstants.h"
+#include "track.h"
+#include "trackGenerator.h"
+#include "inputRecording.h"
+
+// State advanced by one fixed simulation step
+struct GameState {
+    double xOffset;
+    double yOffset;
+    int yLoop;
+    double speedY;
+};
+
+// Input sampled once per frame and applied by the simulation steps of that frame
+struct StepInput {
+    bool left;
+    bool right;
+    double slide;       // Relative slide to apply, in drag units times seconds
+    Point touch;        // Absolute touch position, x is -1 when the screen is not held
+};
+
+// How the ship left the path. A turn is a row where the path changes lane or the row after it
+enum CrashCause { CRASH_NONE, CRASH_OFF_LEFT, CRASH_OFF_RIGHT, CRASH_TURN_LEFT, CRASH_TURN_RIGHT };
+
+// Everything one game needs to advance, independent of any engine, so games can be
+// simulated without drawing and many can run side by side
+struct GameWorld {
+    GameState state;
+    GameState previousState;    // State before the last step, for interpolation
+    double accumulator;         // Frame time not yet simulated
+    double pendingSlide;        // Slide of frames that ran no step, applied by the next step
+    Track tiles;
+    TrackGenerator generator;
+    int nextRow;
+    CrashCause crash;
+    Index2 crashTile;           // Lane and row the ship was on when it crashed
+
+    // Starts a game with its path generated from the seed
+    GameWorld(uint64_t seed);
+};
+
+// Advances the game by one fixed step, returns false if the ship has left the path
+bool stepGame(GameWorld& world, StepInput& input, double width, double height);
+
+// Runs the fixed steps covered by a frame of input, returns false if the ship has left the path.
+// A long frame runs at most SIM_MAX_STEPS steps and the time it could not catch up on is dropped
+bool simulateFrame(GameWorld& world, const InputFrame& frame);
+
+// Blends two states for rendering, the vertical position is blended across row boundaries
+GameState interpolateState(const GameState& previous, const GameState& current, double alpha, double height);
+
+// Hashes the exact bits of a state, so replays can be checked against the recorded game
+uint64_t hashState(const GameState& state);
+
+// Returns the position of the ship in tile units, the row includes the rows already passed
+PointT<double> getShipTilePosition(const GameState& state, double width, double height);
+
+// Returns the score of a game
+int getScore(const GameWorld& world);
+
+// Returns a readable name for a crash cause
+const char* getCrashCauseName(CrashCause cause);
+
+#endif // SIMULATION_H
@@ -0,0 +1,38 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+
+// Lock-free fixed-capacity queue for one producer thread and one consumer thread
+template <typename T, int Capacity>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Appends a value, returns false if the queue is full. Producer only
+    bool push(const T& value) {
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[t % Capacity] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Removes the oldest value, returns false if the queue is empty. Consumer only
+    bool pop(T& value) {
+        unsigned int h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h)
+            return false;
+        value = items[h % Capacity];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<unsigned int> head;     // Written by the consumer
+    std::atomic<unsigned int> tail;     // Written by the producer
+};
+
+#endif // SPSCQUEUE_H
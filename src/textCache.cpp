@@ -0,0 +1,114 @@
+#include <cstring>
+
+#include "textCache.h"
+
+using namespace std;
+
+// FNV-1a hash of a null-terminated string
+static uint32_t hashText(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (; *text; text++) {
+        hash ^= (unsigned char) *text;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int countDigits(int value) {
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+TextCache::TextCache() {
+    clear();
+}
+
+void TextCache::clear() {
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        entries[i].used = false;
+        entries[i].lastUsed = 0;
+        entries[i].text.clear();
+    }
+    clock = 0;
+}
+
+int TextCache::find(int font, const char* text, float size, float spacing, bool& created) {
+    uint32_t hash = hashText(text);
+    int victim = -1;
+    clock++;
+
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        Entry& entry = entries[i];
+        if (entry.used && entry.hash == hash && entry.font == font && entry.size == size &&
+            entry.spacing == spacing && entry.text == text) {
+            entry.lastUsed = clock;
+            created = false;
+            return i;
+        }
+
+        // Remember a free slot, or else the least recently used one, in case this is a miss
+        if (victim < 0 || (entries[victim].used && (!entry.used || entry.lastUsed < entries[victim].lastUsed)))
+            victim = i;
+    }
+
+    Entry& entry = entries[victim];
+    entry.used = true;
+    entry.hash = hash;
+    entry.font = font;
+    entry.size = size;
+    entry.spacing = spacing;
+    entry.text = text;
+    entry.lastUsed = clock;
+    created = true;
+    return victim;
+}
+
+TextCounter::TextCounter(const char* prefix) {
+    prefixLength = (int) strlen(prefix);
+    if (prefixLength > TEXT_COUNTER_SIZE - 12)
+        prefixLength = TEXT_COUNTER_SIZE - 12;
+
+    memcpy(text, prefix, prefixLength);
+    text[prefixLength] = '0';
+    text[prefixLength + 1] = '\0';
+    noDigits = 1;
+    value = 0;
+}
+
+void TextCounter::setValue(int newValue) {
+    if (newValue < 0)
+        newValue = 0;
+    if (newValue == value)
+        return;
+
+    int digits = countDigits(newValue);
+    int oldValue = value;
+    value = newValue;
+
+    // A different length shifts every digit, so the number is written out in full
+    if (digits != noDigits) {
+        noDigits = digits;
+        text[prefixLength + digits] = '\0';
+        oldValue = -1;
+    }
+
+    // Walk from the last digit and stop once the remaining leading digits match
+    char* digit = &text[prefixLength + digits - 1];
+    while (newValue != oldValue && digit >= &text[prefixLength]) {
+        *digit-- = (char) ('0' + newValue % 10);
+        newValue /= 10;
+        oldValue = oldValue < 0 ? -1 : oldValue / 10;
+    }
+}
+
+int TextCounter::getValue() const {
+    return value;
+}
+
+const char* TextCounter::c_str() const {
+    return text;
+}
@@ -0,0 +1,54 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+#define TEXT_CACHE_SLOTS 32
+#define TEXT_COUNTER_SIZE 32
+
+// Fixed-size least recently used map from (font, text, size, spacing) to a slot
+// index, backends keep their prepared text objects and measurements per slot
+class TextCache {
+public:
+    TextCache();
+
+    // Returns the slot for a text, created is set if the slot was (re)assigned and must be prepared
+    int find(int font, const char* text, float size, float spacing, bool& created);
+    void clear();
+
+private:
+    struct Entry {
+        bool used;
+        uint32_t hash;
+        int font;
+        float size;
+        float spacing;
+        string text;
+        uint32_t lastUsed;
+    };
+
+    Entry entries[TEXT_CACHE_SLOTS];
+    uint32_t clock;
+};
+
+// Text made of a fixed prefix followed by a non-negative number, such as a score.
+// Changing the value only rewrites the digits that differ and never allocates
+class TextCounter {
+public:
+    TextCounter(const char* prefix);
+
+    void setValue(int value);
+    int getValue() const;
+    const char* c_str() const;
+
+private:
+    char text[TEXT_COUNTER_SIZE];
+    int prefixLength;
+    int noDigits;
+    int value;
+};
+
+#endif // TEXTCACHE_H
@@ -0,0 +1,47 @@
+#include "track.h"
+
+static_assert((TRACK_ROWS & (TRACK_ROWS - 1)) == 0, "TRACK_ROWS must be a power of two");
+static_assert(TRACK_ROWS >= TRACK_CAPACITY, "TRACK_ROWS must cover every row the path can span");
+static_assert(TRACK_MAX_LANE - TRACK_MIN_LANE < 32, "Lanes must fit in a 32-bit mask");
+
+Track::Track() {
+    clear();
+}
+
+void Track::clear() {
+    path.clear();
+    for (int i = 0; i < TRACK_ROWS; i++)
+        rows[i] = { -1, 0 };
+}
+
+void Track::push(Index2 tile) {
+    path.push_back(tile);
+
+    if (tile.x < TRACK_MIN_LANE || tile.x > TRACK_MAX_LANE)
+        return;
+
+    // Rows share slots modulo TRACK_ROWS, a new row replaces the stale one
+    Row& entry = rows[tile.y & (TRACK_ROWS - 1)];
+    if (entry.row != tile.y)
+        entry = { tile.y, 0 };
+    entry.lanes |= 1u << (tile.x - TRACK_MIN_LANE);
+}
+
+void Track::removeBefore(int row) {
+    while (!path.empty() && path.front().y < row) {
+        Index2 tile = path.front();
+        path.pop_front();
+
+        Row& entry = rows[tile.y & (TRACK_ROWS - 1)];
+        if (entry.row == tile.y)
+            entry = { -1, 0 };
+    }
+}
+
+bool Track::isOccupied(int lane, int row) const {
+    if (lane < TRACK_MIN_LANE || lane > TRACK_MAX_LANE)
+        return false;
+
+    const Row& entry = rows[row & (TRACK_ROWS - 1)];
+    return entry.row == row && (entry.lanes >> (lane - TRACK_MIN_LANE)) & 1u;
+}
@@ -0,0 +1,45 @@
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <cstdint>
+
+#include "shapes.h"
+#include "gameConstants.h"
+#include "ringBuffer.h"
+
+#define TRACK_ROWS 32 // Power of two, at least the number of rows TRACK_CAPACITY tiles can span
+#define TRACK_MIN_LANE (-(NO_V_LINES / 2) + 1)
+#define TRACK_MAX_LANE (TRACK_MIN_LANE + NO_V_LINES - 2)
+
+// Path of tiles ahead of the ship in increasing row order, with a row-indexed
+// table of occupied lanes so a (lane, row) lookup is O(1)
+class Track {
+public:
+    Track();
+
+    // Appends a tile, rows must not decrease
+    void push(Index2 tile);
+    // Removes the tiles on rows before the given row
+    void removeBefore(int row);
+    void clear();
+
+    // Checks if there is a tile at the given lane and row
+    bool isOccupied(int lane, int row) const;
+
+    const Index2* tiles() const { return path.data(); }
+    const Index2& operator[](int i) const { return path[i]; }
+    const Index2& back() const { return path.back(); }
+    int size() const { return path.size(); }
+    bool empty() const { return path.empty(); }
+
+private:
+    struct Row {
+        int row;
+        uint32_t lanes;     // Bit i is set if lane TRACK_MIN_LANE + i has a tile
+    };
+
+    RingBuffer<Index2, TRACK_CAPACITY> path;
+    Row rows[TRACK_ROWS];
+};
+
+#endif // TRACK_H
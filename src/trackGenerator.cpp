@@ -0,0 +1,84 @@
+#include <cstdlib>
+
+#include "trackGenerator.h"
+#include "random.h"
+
+#define NO_LANES (TRACK_MAX_LANE - TRACK_MIN_LANE + 1)
+#define KEYFRAME_STREAM 0x6B657966ull
+#define CHUNK_STREAM 0x6368756Eull
+
+static_assert(TRACK_CHUNK_ROWS >= 2 * NO_LANES, "A chunk must be able to cross every lane");
+
+TrackGenerator::TrackGenerator(uint64_t seed) : seed(seed), cachedChunk(-1) {
+}
+
+uint64_t TrackGenerator::getSeed() const {
+    return seed;
+}
+
+int TrackGenerator::getKeyframeLane(int chunk) const {
+    // The path always starts in the centre lane
+    if (chunk == 0)
+        return 0;
+    return TRACK_MIN_LANE + (int) (hashSeed(seed ^ KEYFRAME_STREAM, chunk) % NO_LANES);
+}
+
+void TrackGenerator::generateChunk(int chunk) {
+    Random random(hashSeed(seed ^ CHUNK_STREAM, chunk));
+    int lane = getKeyframeLane(chunk);
+    int target = getKeyframeLane(chunk + 1);
+    int row = 0;
+
+    while (row < TRACK_CHUNK_ROWS) {
+        int remaining = TRACK_CHUNK_ROWS - row;
+        int distance = abs(target - lane);
+
+        // 0 goes straight, 1 moves right, 2 moves left
+        int r = random.nextInt(0, 2);
+        if (lane <= TRACK_MIN_LANE)
+            r = 1;
+        if (lane >= TRACK_MAX_LANE)
+            r = 2;
+
+        // A straight takes one row and a turn two, the move must still let the path reach the target
+        int turn = r == 1 ? 1 : r == 2 ? -1 : 0;
+        int newLane = lane + turn;
+        int newDistance = abs(target - newLane);
+        int newRemaining = remaining - (turn == 0 ? 1 : 2);
+        bool valid = newRemaining >= 0 && 2 * newDistance <= newRemaining &&
+            newLane >= TRACK_MIN_LANE && newLane <= TRACK_MAX_LANE;
+
+        if (!valid) {
+            if (distance > 0 && 2 * distance > remaining - 1)
+                turn = target > lane ? 1 : -1;
+            else
+                turn = 0;
+        }
+
+        chunkRows[row++] = { lane, turn };
+        if (turn != 0) {
+            lane += turn;
+            chunkRows[row++] = { lane, 0 };
+        }
+    }
+
+    cachedChunk = chunk;
+}
+
+TrackRow TrackGenerator::getRow(int row) {
+    // The starting rows are a straight run in the centre lane
+    if (row < NO_STARTING_TILES)
+        return { 0, 0 };
+
+    int chunk = (row - NO_STARTING_TILES) / TRACK_CHUNK_ROWS;
+    if (chunk != cachedChunk)
+        generateChunk(chunk);
+    return chunkRows[(row - NO_STARTING_TILES) % TRACK_CHUNK_ROWS];
+}
+
+void TrackGenerator::addRow(Track& track, int row) {
+    TrackRow path = getRow(row);
+    track.push({ path.lane, row });
+    if (path.turn != 0)
+        track.push({ path.lane + path.turn, row });
+}
@@ -0,0 +1,40 @@
+#ifndef TRACKGENERATOR_H
+#define TRACKGENERATOR_H
+
+#include <cstdint>
+
+#include "track.h"
+
+#define TRACK_CHUNK_ROWS 16 // Rows between lane keyframes, must be at least twice the lane count
+
+// Path on a single row: the tile at lane, plus a second tile at lane + turn when the path turns
+struct TrackRow {
+    int lane;
+    int turn;
+};
+
+// Procedural path keyed by a 64-bit seed. Every TRACK_CHUNK_ROWS rows the
+// lane is a pure function of the seed and chunk index, and the path between
+// two keyframes is generated from a per-chunk random stream, so any row can
+// be computed on demand without generating the rows before it
+class TrackGenerator {
+public:
+    TrackGenerator(uint64_t seed);
+
+    uint64_t getSeed() const;
+
+    // Returns the path on a row, rows can be requested in any order
+    TrackRow getRow(int row);
+    // Appends the tiles of a row to a track
+    void addRow(Track& track, int row);
+
+private:
+    uint64_t seed;
+    int cachedChunk;
+    TrackRow chunkRows[TRACK_CHUNK_ROWS];
+
+    int getKeyframeLane(int chunk) const;
+    void generateChunk(int chunk);
+};
+
+#endif // TRACKGENERATOR_H
@@ -0,0 +1,46 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer, single consumer hand-off of the latest value.
+// The producer fills the back buffer and publishes it, the consumer picks up the
+// newest published buffer. Neither side ever waits for the other, values the
+// consumer did not get to in time are skipped
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Buffer the producer fills before publishing it
+    T& writeBuffer() { return buffers[back]; }
+
+    // Makes the write buffer the newest value and hands the producer a free one
+    void publish() {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Switches to the newest value if one was published since the last call,
+    // returns false if the value has not changed
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // Value the consumer is reading, stays put until the next update
+    const T& read() const { return buffers[front]; }
+
+private:
+    static const uint8_t INDEX_MASK = 3;
+    static const uint8_t FRESH_BIT = 4;
+
+    T buffers[3];
+    std::atomic<uint8_t> middle;    // Index of the buffer between the two sides, plus FRESH_BIT
+    uint8_t back;                   // Owned by the producer
+    uint8_t front;                  // Owned by the consumer
+};
+
+#endif // TRIPLEBUFFER_H
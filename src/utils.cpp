@@ -6,9 +6,36 @@
 #include <cmath>
 #include "utils.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PERSPECTIVE_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PERSPECTIVE_NEON
+#endif
+
 using namespace std;
 
-Point transformPerspective(Point v, Point pp, double height) {
+// The perspective transform simplifies to out = pp + s * (x - pp.x, height - pp.y)
+// with s = max(y / height, 0)^2, so everything but s is constant across a batch. Keeping
+// the products small also keeps them in range for fixed point, where y * pp.y would overflow
+template <typename T>
+PointT<T> transformPerspective(PointT<T> v, PointT<T> pp, double height) {
+    if (PERPECTIVE_MODE) {
+        T h = T(height);
+        T s = max(v.y / h, T(0));
+        s *= s;
+        return { pp.x + s * (v.x - pp.x), pp.y + s * (h - pp.y) };
+    }
+    else {
+        return v;
+    }
+}
+
+// Double keeps the original formulation, which compiles to scalar code without the stack
+// round trip the vectorizer adds to the one above
+template <>
+PointT<double> transformPerspective(PointT<double> v, PointT<double> pp, double height) {
     if (PERPECTIVE_MODE) {
         // Invert the y-coordinate to match the top-left origin system
         double x = v.x;
@@ -36,16 +63,91 @@ Point transformPerspective(Point v, Point pp, double height) {
     }
 }
 
-double getLineXFromIndex(int i, Point pp, double width, double currentXOffset) {
-    double centreX = pp.x;
-    double spacing = V_LINE_SPACING * width;
-    double offset = i - 0.5;
-    return centreX + offset * spacing + currentXOffset;
+template <typename T>
+void transformPerspectiveBatch(const PointT<T>* in, PointT<T>* out, int count, PointT<T> pp, double height) {
+    for (int i = 0; i < count; i++)
+        out[i] = transformPerspective(in[i], pp, height);
 }
 
-double getLineYFromIndex(int i, double height, double currentYOffset) {
-    double spacingY = H_LINE_SPACING * height;
-    return (NO_H_LINES - 1 - i) * spacingY + currentYOffset;
+// Double batches are vectorized, the scalar loop multiplies by the reciprocal instead of dividing
+template <>
+void transformPerspectiveBatch(const PointT<double>* in, PointT<double>* out, int count, PointT<double> pp,
+    double height) {
+    if (!PERPECTIVE_MODE) {
+        if (in != out)
+            copy(in, in + count, out);
+        return;
+    }
+
+    double invHeight = 1.0 / height;
+    double scaleY = height - pp.y;
+    int i = 0;
+
+#if defined(PERSPECTIVE_SSE2)
+    __m128d vInvHeight = _mm_set1_pd(invHeight);
+    __m128d vPpX = _mm_set1_pd(pp.x);
+    __m128d vPpY = _mm_set1_pd(pp.y);
+    __m128d vScaleY = _mm_set1_pd(scaleY);
+    __m128d vZero = _mm_setzero_pd();
+
+    // Two points per iteration: split into x and y lanes, project, then interleave back
+    for (; i + 2 <= count; i += 2) {
+        __m128d a = _mm_loadu_pd(&in[i].x);
+        __m128d b = _mm_loadu_pd(&in[i + 1].x);
+        __m128d xs = _mm_unpacklo_pd(a, b);
+        __m128d ys = _mm_unpackhi_pd(a, b);
+
+        __m128d s = _mm_max_pd(_mm_mul_pd(ys, vInvHeight), vZero);
+        s = _mm_mul_pd(s, s);
+
+        __m128d outX = _mm_add_pd(vPpX, _mm_mul_pd(s, _mm_sub_pd(xs, vPpX)));
+        __m128d outY = _mm_add_pd(vPpY, _mm_mul_pd(s, vScaleY));
+
+        _mm_storeu_pd(&out[i].x, _mm_unpacklo_pd(outX, outY));
+        _mm_storeu_pd(&out[i + 1].x, _mm_unpackhi_pd(outX, outY));
+    }
+#elif defined(PERSPECTIVE_NEON)
+    float64x2_t vInvHeight = vdupq_n_f64(invHeight);
+    float64x2_t vPpX = vdupq_n_f64(pp.x);
+    float64x2_t vPpY = vdupq_n_f64(pp.y);
+    float64x2_t vScaleY = vdupq_n_f64(scaleY);
+    float64x2_t vZero = vdupq_n_f64(0.0);
+
+    // Two points per iteration, the structured load splits x and y lanes
+    for (; i + 2 <= count; i += 2) {
+        float64x2x2_t p = vld2q_f64(&in[i].x);
+
+        float64x2_t s = vmaxq_f64(vmulq_f64(p.val[1], vInvHeight), vZero);
+        s = vmulq_f64(s, s);
+
+        float64x2x2_t r;
+        r.val[0] = vfmaq_f64(vPpX, s, vsubq_f64(p.val[0], vPpX));
+        r.val[1] = vfmaq_f64(vPpY, s, vScaleY);
+        vst2q_f64(&out[i].x, r);
+    }
+#endif
+
+    // Scalar fallback and remainder
+    for (; i < count; i++) {
+        double s = max(in[i].y * invHeight, 0.0);
+        s *= s;
+        out[i].x = pp.x + s * (in[i].x - pp.x);
+        out[i].y = pp.y + s * scaleY;
+    }
+}
+
+template <typename T>
+T getLineXFromIndex(int i, PointT<T> pp, double width, double currentXOffset) {
+    T centreX = pp.x;
+    T spacing = T(V_LINE_SPACING * width);
+    T offset = T(i - 0.5);
+    return centreX + offset * spacing + T(currentXOffset);
+}
+
+template <typename T>
+T getLineYFromIndex(int i, double height, double currentYOffset) {
+    T spacingY = T(H_LINE_SPACING * height);
+    return T(NO_H_LINES - 1 - i) * spacingY + T(currentYOffset);
 }
 
 long long getCurrentTimeMillis() {
@@ -58,44 +160,84 @@ long long getCurrentTimeMillis() {
     return millis;
 }
 
-int getRandomInt(int a, int b) {
-    // Seed the random number generator with the current time
-    srand((unsigned int)getCurrentTimeMillis());
-
-    // Generate a random integer between a and b
-    return a + (rand() % (b - a + 1));
-}
-
-Point getTileCoordinates(int tX, int tY, Point pp, double width, double height,
+template <typename T>
+PointT<T> getTileCoordinates(int tX, int tY, PointT<T> pp, double width, double height,
     double currentXOffset, double currentYOffset, int currentYLoop) {
     tY = tY - currentYLoop;
-    Point p;
+    PointT<T> p;
     p.x = getLineXFromIndex(tX, pp, width, currentXOffset);
-    p.y = getLineYFromIndex(tY - 1, height, currentYOffset);
+    p.y = getLineYFromIndex<T>(tY - 1, height, currentYOffset);
     return p;
 }
 
-bool checkShipCollisionWithTile(Point shipCenter, int tX, int tY,
-    Point pp, double width, double height, double currentXOffset,
+template <typename T>
+PointT<T> getTilePosition(PointT<T> p, PointT<T> pp, double width, double height,
+    double currentXOffset, double currentYOffset) {
+    // Invert getLineXFromIndex: tile x spans the lines x and x + 1
+    T spacingX = T(V_LINE_SPACING * width);
+    T lane = (p.x - pp.x - T(currentXOffset)) / spacingX + T(0.5);
+
+    // Invert getLineYFromIndex: tile y spans the lines y - 1 and y
+    T spacingY = T(H_LINE_SPACING * height);
+    T row = T(NO_H_LINES) - (p.y - T(currentYOffset)) / spacingY;
+
+    return { lane, row };
+}
+
+template <typename T>
+Index2 getTileIndex(PointT<T> p, PointT<T> pp, double width, double height,
+    double currentXOffset, double currentYOffset, int currentYLoop) {
+    PointT<T> t = getTilePosition(p, pp, width, height, currentXOffset, currentYOffset);
+    return { (int) floor(t.x), (int) floor(t.y) + currentYLoop };
+}
+
+template <typename T>
+bool checkShipCollisionWithTile(PointT<T> shipCenter, int tX, int tY,
+    PointT<T> pp, double width, double height, double currentXOffset,
     double currentYOffset, int currentYLoop) {
-    Point minP = getTileCoordinates(tX, tY, pp, width, height, currentXOffset,
+    PointT<T> minP = getTileCoordinates(tX, tY, pp, width, height, currentXOffset,
         currentYOffset, currentYLoop);
-    Point maxP = getTileCoordinates(tX + 1, tY + 1, pp, width, height, currentXOffset,
+    PointT<T> maxP = getTileCoordinates(tX + 1, tY + 1, pp, width, height, currentXOffset,
         currentYOffset, currentYLoop);
 
     return minP.x <= shipCenter.x && shipCenter.x <= maxP.x &&
         maxP.y <= shipCenter.y && shipCenter.y <= minP.y;
 }
 
-bool checkShipCollision(const vector<Index2>& tiles, Point shipCenter, Point pp, double width, double height,
+template <typename T>
+bool checkShipCollision(const Track& track, PointT<T> shipCenter, PointT<T> pp, double width, double height,
     double currentXOffset, double currentYOffset, int currentYLoop) {
-    for (int i = 0; i < (int)tiles.size(); i++) {
-        Index2 tile = tiles[i];
-        if (tile.y > currentYLoop + 1)
-            return false;
-        if (checkShipCollisionWithTile(shipCenter, tile.x, tile.y, pp, width, height,
-            currentXOffset, currentYOffset, currentYLoop))
-            return true;
-    }
-    return false;
-}
\ No newline at end of file
+    PointT<T> t = getTilePosition(shipCenter, pp, width, height, currentXOffset, currentYOffset);
+    int lane = (int) floor(t.x);
+    int row = (int) floor(t.y) + currentYLoop;
+
+    if (track.isOccupied(lane, row))
+        return true;
+
+    // Tile edges are inclusive, so a point exactly on an edge also touches the neighbouring tile
+    bool onLaneEdge = t.x == floor(t.x);
+    bool onRowEdge = t.y == floor(t.y);
+    return (onLaneEdge && track.isOccupied(lane - 1, row)) ||
+        (onRowEdge && track.isOccupied(lane, row - 1)) ||
+        (onLaneEdge && onRowEdge && track.isOccupied(lane - 1, row - 1));
+}
+
+#define INSTANTIATE_GEOMETRY(T) \
+    template T getLineXFromIndex(int, PointT<T>, double, double); \
+    template T getLineYFromIndex(int, double, double); \
+    template PointT<T> getTileCoordinates(int, int, PointT<T>, double, double, double, double, int); \
+    template PointT<T> getTilePosition(PointT<T>, PointT<T>, double, double, double, double); \
+    template Index2 getTileIndex(PointT<T>, PointT<T>, double, double, double, double, int); \
+    template bool checkShipCollisionWithTile(PointT<T>, int, int, PointT<T>, double, double, double, double, \
+        int); \
+    template bool checkShipCollision(const Track&, PointT<T>, PointT<T>, double, double, double, double, int);
+
+INSTANTIATE_GEOMETRY(double)
+INSTANTIATE_GEOMETRY(float)
+INSTANTIATE_GEOMETRY(Fixed16)
+
+// Double has its own specializations of the perspective transforms
+template PointT<float> transformPerspective(PointT<float>, PointT<float>, double);
+template PointT<Fixed16> transformPerspective(PointT<Fixed16>, PointT<Fixed16>, double);
+template void transformPerspectiveBatch(const PointT<float>*, PointT<float>*, int, PointT<float>, double);
+template void transformPerspectiveBatch(const PointT<Fixed16>*, PointT<Fixed16>*, int, PointT<Fixed16>, double);
@@ -6,35 +6,61 @@
 
 #include "shapes.h"
 #include "gameConstants.h"
+#include "track.h"
 
 using namespace std;
 
+// The geometry helpers are templated on the scalar type of their points and instantiated
+// for double, float and Fixed16, sizes and offsets come from the game state in double
+
 // Maps a point with respect to a perspective point
-Point transformPerspective(Point v, Point pp, double height);
+template <typename T>
+PointT<T> transformPerspective(PointT<T> v, PointT<T> pp, double height);
+template <>
+PointT<double> transformPerspective(PointT<double> v, PointT<double> pp, double height);
+
+// Maps an array of points with respect to a perspective point, in and out may be the same array
+template <typename T>
+void transformPerspectiveBatch(const PointT<T>* in, PointT<T>* out, int count, PointT<T> pp, double height);
+template <>
+void transformPerspectiveBatch(const PointT<double>* in, PointT<double>* out, int count, PointT<double> pp,
+    double height);
 
 // Returns the x coordinate given a vertical line index
-double getLineXFromIndex(int i, Point pp, double width, double currentXOffset);
+template <typename T>
+T getLineXFromIndex(int i, PointT<T> pp, double width, double currentXOffset);
 
 // Returns the y coordinate given a vertical line index
-double getLineYFromIndex(int i, double height, double currentYOffset);
+template <typename T = Scalar>
+T getLineYFromIndex(int i, double height, double currentYOffset);
 
 // Returns the current time in milliseconds
 long long getCurrentTimeMillis();
 
-// Generates a random integer between a and b inclusive
-int getRandomInt(int a, int b);
-
 // Returns bottom-left tile coordinates given its index
-Point getTileCoordinates(int tX, int tY, Point pp, double width, double height,
+template <typename T>
+PointT<T> getTileCoordinates(int tX, int tY, PointT<T> pp, double width, double height,
+    double currentXOffset, double currentYOffset, int currentYLoop);
+
+// Returns the position of a point in tile units, relative to the current loop
+template <typename T>
+PointT<T> getTilePosition(PointT<T> p, PointT<T> pp, double width, double height,
+    double currentXOffset, double currentYOffset);
+
+// Returns the index of the tile containing a point, the inverse of getTileCoordinates
+template <typename T>
+Index2 getTileIndex(PointT<T> p, PointT<T> pp, double width, double height,
     double currentXOffset, double currentYOffset, int currentYLoop);
 
 // Checks if the ship has collided with a specified tile
-bool checkShipCollisionWithTile(Point shipCenter, int tX, int tY,
-    Point pp, double width, double height, double currentXOffset,
+template <typename T>
+bool checkShipCollisionWithTile(PointT<T> shipCenter, int tX, int tY,
+    PointT<T> pp, double width, double height, double currentXOffset,
     double currentYOffset, int currentYLoop);
 
-// Checks if the ship has collided with any tiles
-bool checkShipCollision(const vector<Index2>& tiles, Point shipCenter, Point pp, double width, double height,
+// Checks if the ship has collided with any tiles on the track
+template <typename T>
+bool checkShipCollision(const Track& track, PointT<T> shipCenter, PointT<T> pp, double width, double height,
     double currentXOffset, double currentYOffset, int currentYLoop);
 
 #endif // UTILS_H
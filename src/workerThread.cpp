@@ -0,0 +1,92 @@
+#include "workerThread.h"
+
+#ifndef __3DS__
+#include <system_error>
+#endif
+
+WorkerThread::WorkerThread() : running(false) {
+#ifdef __3DS__
+    thread = nullptr;
+#endif
+}
+
+WorkerThread::~WorkerThread() {
+    join();
+}
+
+bool WorkerThread::start(void (*entry)(void*), void* arg) {
+#ifdef __3DS__
+    s32 priority = 0x30;
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+
+    // Core 1 only runs application threads for the share of time lent by the system
+    bool isNew3DS = false;
+    APT_CheckNew3DS(&isNew3DS);
+    int core = isNew3DS ? 2 : 1;
+    if (!isNew3DS)
+        APT_SetAppCpuTimeLimit(WORKER_CPU_TIME_LIMIT);
+
+    thread = threadCreate(entry, arg, WORKER_STACK_SIZE, priority, core, false);
+    if (!thread)
+        thread = threadCreate(entry, arg, WORKER_STACK_SIZE, priority, -2, false);
+    running = thread != nullptr;
+#else
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    // std::thread reports a thread that could not be created by throwing
+    try {
+        thread = std::thread(entry, arg);
+    } catch (const std::system_error&) {
+        return false;
+    }
+#else
+    thread = std::thread(entry, arg);
+#endif
+    running = true;
+#endif
+    return running;
+}
+
+void WorkerThread::join() {
+    if (!running)
+        return;
+
+#ifdef __3DS__
+    threadJoin(thread, U64_MAX);
+    threadFree(thread);
+    thread = nullptr;
+#else
+    thread.join();
+#endif
+    running = false;
+}
+
+#ifdef __3DS__
+WorkerEvent::WorkerEvent() {
+    LightEvent_Init(&event, RESET_ONESHOT);
+}
+
+void WorkerEvent::signal() {
+    LightEvent_Signal(&event);
+}
+
+void WorkerEvent::wait() {
+    LightEvent_Wait(&event);
+}
+#else
+WorkerEvent::WorkerEvent() : signalled(false) {}
+
+void WorkerEvent::signal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        signalled = true;
+    }
+    condition.notify_one();
+}
+
+void WorkerEvent::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!signalled)
+        condition.wait(lock);
+    signalled = false;
+}
+#endif
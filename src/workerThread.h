@@ -0,0 +1,56 @@
+#ifndef WORKERTHREAD_H
+#define WORKERTHREAD_H
+
+#ifdef __3DS__
+#include <3ds.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#define WORKER_STACK_SIZE (64 * 1024)
+#define WORKER_CPU_TIME_LIMIT 80 // Percentage of the old 3DS system core lent to the game
+
+// Runs a function on another core: the spare application core of a New 3DS, the system
+// core of an old 3DS, or any core the OS picks on desktop
+class WorkerThread {
+public:
+    WorkerThread();
+    ~WorkerThread();
+
+    // Starts running entry(arg), returns false if no thread could be created
+    bool start(void (*entry)(void*), void* arg);
+    // Waits for the function to return
+    void join();
+
+private:
+#ifdef __3DS__
+    Thread thread;
+#else
+    std::thread thread;
+#endif
+    bool running;
+};
+
+// Wakes a thread blocked on a condition another thread changes. A signal sent while nobody
+// waits is kept, so the waiter checks its condition, waits and checks again without missing it
+class WorkerEvent {
+public:
+    WorkerEvent();
+
+    void signal();
+    // Blocks until the event is signalled, then clears it
+    void wait();
+
+private:
+#ifdef __3DS__
+    LightEvent event;
+#else
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool signalled;
+#endif
+};
+
+#endif // WORKERTHREAD_H
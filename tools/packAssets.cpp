@@ -0,0 +1,270 @@
+// Builds an asset pack (see src/assetPack.h) so the game can start without
+// decoding images or rasterizing fonts.
+//
+// Usage: packAssets output.pak [--root dir] files...
+//   .png files are decoded and packed into RGBA atlas pages
+//   .ttf files are baked into a glyph atlas per size bucket, with only the characters the game draws
+//   other files, such as the .t3x sheets and .bcfnt fonts built for the 3DS, are stored as is
+// Assets are named by their path with the --root prefix removed, which must match
+// the path the game loads them by
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <raylib.h>
+
+#include "assetPack.h"
+#include "atlas.h"
+#include "fontBuckets.h"
+
+using namespace std;
+
+#define FONT_GLYPH_PADDING 4   // As raylib uses when rasterizing a font
+
+struct PendingEntry {
+    AssetEntry entry;
+    vector<unsigned char> data;
+};
+
+static bool hasExtension(const string& path, const char* extension) {
+    size_t length = strlen(extension);
+    return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+static AssetEntry makeEntry(const string& name, AssetType type) {
+    AssetEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, name.c_str(), ASSET_NAME_SIZE - 1);
+    entry.type = type;
+    return entry;
+}
+
+// Adds a texture entry holding a copy of the image pixels and returns its index
+static int addTexture(vector<PendingEntry>& entries, const string& name, const Image& image) {
+    PendingEntry texture;
+    texture.entry = makeEntry(name, ASSET_TEXTURE);
+    texture.entry.texture.width = image.width;
+    texture.entry.texture.height = image.height;
+    texture.entry.texture.format = image.format;
+
+    int size = GetPixelDataSize(image.width, image.height, image.format);
+    const unsigned char* pixels = (const unsigned char*) image.data;
+    texture.data.assign(pixels, pixels + size);
+
+    entries.push_back(texture);
+    return (int) entries.size() - 1;
+}
+
+// Packs the images into atlas pages, adding a texture per page and an image entry per image
+static bool addImages(vector<PendingEntry>& entries, const vector<string>& paths, const vector<string>& names) {
+    vector<Image> images;
+    vector<AtlasSize> sizes;
+    for (size_t i = 0; i < paths.size(); i++) {
+        Image image = LoadImage(paths[i].c_str());
+        if (image.data == nullptr) {
+            fprintf(stderr, "Could not load image %s\n", paths[i].c_str());
+            return false;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        images.push_back(image);
+        sizes.push_back({ image.width, image.height });
+    }
+
+    vector<AtlasRect> rects;
+    vector<AtlasSize> pageSizes = packAtlas(sizes, ATLAS_MAX_SIZE, ATLAS_PADDING, rects);
+
+    for (size_t page = 0; page < pageSizes.size(); page++) {
+        Image pageImage = GenImageColor(pageSizes[page].width, pageSizes[page].height, BLANK);
+        for (size_t i = 0; i < images.size(); i++) {
+            if (rects[i].page != (int) page)
+                continue;
+            for (int y = 0; y < rects[i].height; y++) {
+                memcpy((unsigned char*) pageImage.data + ((size_t) (rects[i].y + y) * pageImage.width + rects[i].x) * 4,
+                    (unsigned char*) images[i].data + (size_t) y * rects[i].width * 4, (size_t) rects[i].width * 4);
+            }
+        }
+
+        int texture = addTexture(entries, "atlas" + to_string(page), pageImage);
+        UnloadImage(pageImage);
+
+        for (size_t i = 0; i < images.size(); i++) {
+            if (rects[i].page != (int) page)
+                continue;
+            PendingEntry image;
+            image.entry = makeEntry(names[i], ASSET_IMAGE);
+            image.entry.image = { texture, rects[i].x, rects[i].y, rects[i].width, rects[i].height };
+            entries.push_back(image);
+        }
+    }
+
+    for (Image& image : images)
+        UnloadImage(image);
+    return true;
+}
+
+// Bakes one size bucket of a font the way LoadFontFromMemory does, adding its glyph atlas and glyph table
+static bool addFontBucket(vector<PendingEntry>& entries, const unsigned char* fileData, int fileSize,
+    const string& name, int fontSize) {
+    vector<int> codepoints = getFontCodepoints();
+    int glyphCount = (int) codepoints.size();
+    GlyphInfo* glyphs = LoadFontData(fileData, fileSize, fontSize, codepoints.data(), glyphCount, FONT_DEFAULT);
+    if (!glyphs) {
+        fprintf(stderr, "Could not rasterize %s\n", name.c_str());
+        return false;
+    }
+
+    Rectangle* recs = nullptr;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, glyphCount, fontSize, FONT_GLYPH_PADDING, 0);
+    int texture = addTexture(entries, name + ".atlas", atlas);
+    UnloadImage(atlas);
+
+    PendingEntry font;
+    font.entry = makeEntry(name, ASSET_FONT);
+    font.entry.font = { fontSize, glyphCount, FONT_GLYPH_PADDING, texture };
+    for (int i = 0; i < glyphCount; i++) {
+        AssetGlyph glyph = { glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX,
+            recs[i].x, recs[i].y, recs[i].width, recs[i].height };
+        const unsigned char* bytes = (const unsigned char*) &glyph;
+        font.data.insert(font.data.end(), bytes, bytes + sizeof(glyph));
+    }
+    entries.push_back(font);
+
+    UnloadFontData(glyphs, glyphCount);
+    MemFree(recs);
+    return true;
+}
+
+static bool addFont(vector<PendingEntry>& entries, const string& path, const string& name) {
+    int fileSize = 0;
+    unsigned char* fileData = LoadFileData(path.c_str(), &fileSize);
+    if (!fileData) {
+        fprintf(stderr, "Could not load font %s\n", path.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < NO_FONT_BUCKETS && ok; i++)
+        ok = addFontBucket(entries, fileData, fileSize, getFontBucketName(name, i), FONT_BUCKET_SIZES[i]);
+
+    UnloadFileData(fileData);
+    return ok;
+}
+
+static bool addBlob(vector<PendingEntry>& entries, const string& path, const string& name) {
+    int size = 0;
+    unsigned char* data = LoadFileData(path.c_str(), &size);
+    if (!data) {
+        fprintf(stderr, "Could not read %s\n", path.c_str());
+        return false;
+    }
+
+    PendingEntry blob;
+    blob.entry = makeEntry(name, ASSET_BLOB);
+    blob.data.assign(data, data + size);
+    entries.push_back(blob);
+    UnloadFileData(data);
+    return true;
+}
+
+static bool pad(FILE* file, long& offset) {
+    while (offset % ASSET_ALIGNMENT != 0) {
+        if (fputc(0, file) == EOF)
+            return false;
+        offset++;
+    }
+    return true;
+}
+
+// Every write is checked, so a full disk fails the build instead of leaving a truncated pack
+static bool writePack(const char* filename, vector<PendingEntry>& entries) {
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    AssetPackHeader header = { ASSET_PACK_MAGIC, ASSET_PACK_VERSION, (uint32_t) entries.size(), 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    long offset = sizeof(header);
+
+    // Data in entry order, so a sequential read follows the order assets are loaded in
+    for (size_t i = 0; i < entries.size() && ok; i++) {
+        PendingEntry& pending = entries[i];
+        ok = pad(file, offset);
+        pending.entry.offset = (uint32_t) offset;
+        pending.entry.size = (uint32_t) pending.data.size();
+        ok = ok && fwrite(pending.data.data(), 1, pending.data.size(), file) == pending.data.size();
+        offset += (long) pending.data.size();
+    }
+
+    ok = ok && pad(file, offset);
+    header.tocOffset = (uint32_t) offset;
+    for (size_t i = 0; i < entries.size() && ok; i++)
+        ok = fwrite(&entries[i].entry, sizeof(entries[i].entry), 1, file) == 1;
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+
+    // A partial pack would be picked up by the game, so it is removed
+    if (!ok)
+        remove(filename);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s output.pak [--root dir] files...\n", argv[0]);
+        return 2;
+    }
+
+    string root;
+    vector<string> imagePaths, imageNames, otherPaths;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--root") && i + 1 < argc)
+            root = argv[++i];
+        else if (hasExtension(argv[i], ".png"))
+            imagePaths.push_back(argv[i]);
+        else
+            otherPaths.push_back(argv[i]);
+    }
+    if (!root.empty() && root[root.size() - 1] != '/')
+        root += '/';
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    // Names are checked first so a long one fails before any decoding
+    vector<string> otherNames;
+    bool ok = true;
+    for (size_t i = 0; i < imagePaths.size() + otherPaths.size(); i++) {
+        const string& path = i < imagePaths.size() ? imagePaths[i] : otherPaths[i - imagePaths.size()];
+        string name = path.compare(0, root.size(), root) == 0 ? path.substr(root.size()) : path;
+        // Fonts are stored per bucket, with the longest suffix being the largest size
+        size_t length = hasExtension(path, ".ttf")
+            ? getFontBucketName(name, NO_FONT_BUCKETS - 1).size() + strlen(".atlas") : name.size();
+        if (length >= ASSET_NAME_SIZE) {
+            fprintf(stderr, "Asset name %s is longer than %d characters\n", name.c_str(), ASSET_NAME_SIZE - 1);
+            ok = false;
+        }
+        (i < imagePaths.size() ? imageNames : otherNames).push_back(name);
+    }
+
+    // Images come first, as the game loads them before the fonts
+    vector<PendingEntry> entries;
+    if (ok && !imagePaths.empty())
+        ok = addImages(entries, imagePaths, imageNames);
+    for (size_t i = 0; i < otherPaths.size() && ok; i++) {
+        if (hasExtension(otherPaths[i], ".ttf"))
+            ok = addFont(entries, otherPaths[i], otherNames[i]);
+        else
+            ok = addBlob(entries, otherPaths[i], otherNames[i]);
+    }
+
+    if (!ok || !writePack(argv[1], entries)) {
+        fprintf(stderr, "Could not build %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %d entries\n", argv[1], (int) entries.size());
+    return 0;
+}